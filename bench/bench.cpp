@@ -0,0 +1,368 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+std::vector<BenchCase>& benchRegistry()
+{
+    static std::vector<BenchCase> cases;
+    return cases;
+}
+
+BenchRegistrar::BenchRegistrar(BenchCase benchCase)
+{
+    benchRegistry().push_back(std::move(benchCase));
+}
+
+void BenchRandom::fill(std::vector<uint8_t>& buffer)
+{
+    static const char* const words[] = { "var ", "const ", "return ", "this.", "function", "(){", "});\n", "  ", "pref(", "\"sine\"" };
+    size_t i = 0;
+    while (i < buffer.size())
+    {
+        const uint32_t r = next();
+        if (r & 3)
+        {
+            const char* word = words[(r >> 2) % (sizeof(words) / sizeof(words[0]))];
+            for (size_t j = 0; word[j] && i < buffer.size(); ++j) buffer[i++] = static_cast<uint8_t>(word[j]);
+        }
+        else
+        {
+            buffer[i++] = static_cast<uint8_t>('a' + (r >> 8) % 26);
+        }
+    }
+}
+
+size_t peakRssBytes()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+namespace
+{
+    struct BenchResult
+    {
+        std::string name;
+        bool ok;
+        int iterations;
+        int64_t bytes;
+        std::vector<double> millis;
+        size_t peakRss = 0;
+        // False when the peak could not be told apart from other cases'.
+        bool peakRssKnown = false;
+    };
+
+    double percentile(const std::vector<double>& sorted, double p)
+    {
+        if (sorted.empty()) return 0.0;
+        const double rank = p * (sorted.size() - 1);
+        const size_t low = static_cast<size_t>(rank);
+        const size_t high = std::min(low + 1, sorted.size() - 1);
+        return sorted[low] + (sorted[high] - sorted[low]) * (rank - low);
+    }
+
+    std::string jsonString(const std::string& value)
+    {
+        std::string out = "\"";
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            out.push_back(c);
+        }
+        out.push_back('"');
+        return out;
+    }
+
+    void writeJson(std::ostream& out, const std::vector<BenchResult>& results)
+    {
+        char number[64];
+        out << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchResult& result = results[i];
+            std::vector<double> sorted = result.millis;
+            std::sort(sorted.begin(), sorted.end());
+
+            double total = 0.0;
+            for (double ms : sorted) total += ms;
+            const double mean = sorted.empty() ? 0.0 : total / sorted.size();
+            const double mbps = result.bytes > 0 && mean > 0.0
+                ? result.bytes / (1024.0 * 1024.0) / (mean / 1000.0) : 0.0;
+
+            out << (i ? ",\n" : "\n") << "    {\n";
+            out << "      \"name\": " << jsonString(result.name) << ",\n";
+            out << "      \"ok\": " << (result.ok ? "true" : "false") << ",\n";
+            out << "      \"iterations\": " << sorted.size() << ",\n";
+            out << "      \"bytes\": " << result.bytes << ",\n";
+            std::snprintf(number, sizeof(number), "%.3f", mbps);
+            out << "      \"mb_per_s\": " << number << ",\n";
+            std::snprintf(number, sizeof(number), "%.4f", mean);
+            out << "      \"mean_ms\": " << number << ",\n";
+
+            const std::pair<const char*, double> stats[] = {
+                { "min_ms", sorted.empty() ? 0.0 : sorted.front() },
+                { "p50_ms", percentile(sorted, 0.50) },
+                { "p90_ms", percentile(sorted, 0.90) },
+                { "p99_ms", percentile(sorted, 0.99) },
+                { "max_ms", sorted.empty() ? 0.0 : sorted.back() },
+            };
+            for (const auto& stat : stats)
+            {
+                std::snprintf(number, sizeof(number), "%.4f", stat.second);
+                out << "      \"" << stat.first << "\": " << number << ",\n";
+            }
+            out << "      \"peak_rss_bytes\": ";
+            if (result.peakRssKnown) out << result.peakRss << "\n";
+            else out << "null\n";
+            out << "    }";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+    uint32_t nameSeed(const std::string& name)
+    {
+        // FNV-1a, so every case gets its own but stable fixture.
+        uint32_t hash = 2166136261u;
+        for (unsigned char c : name)
+        {
+            hash ^= c;
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    BenchResult runCase(const BenchCase& benchCase, const std::filesystem::path& root, int iterations)
+    {
+        BenchContext context;
+        context.workDir = (root / benchCase.name).string();
+        context.seed = nameSeed(benchCase.name);
+
+        std::error_code ec;
+        std::filesystem::remove_all(context.workDir, ec);
+        std::filesystem::create_directories(context.workDir, ec);
+
+        BenchResult result;
+        result.name = benchCase.name;
+        result.iterations = iterations > 0 ? iterations : benchCase.iterations;
+        result.bytes = benchCase.setup ? benchCase.setup(context) : 0;
+        result.ok = result.bytes >= 0;
+
+        // One untimed warm-up so page cache and connection setup don't skew p99.
+        if (result.ok) result.ok = benchCase.run(context);
+
+        for (int i = 0; result.ok && i < result.iterations; ++i)
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            result.ok = benchCase.run(context);
+            const auto end = std::chrono::steady_clock::now();
+            result.millis.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+        }
+
+        if (benchCase.teardown) benchCase.teardown(context);
+        result.peakRss = peakRssBytes();
+        std::filesystem::remove_all(context.workDir, ec);
+        return result;
+    }
+
+#ifndef _WIN32
+    // Runs the case in a forked child, whose high-water mark starts from the
+    // runner's (which never runs a case itself) instead of the largest case so
+    // far. The result comes back through a pipe as one line of text.
+    BenchResult runIsolated(const BenchCase& benchCase, const std::filesystem::path& root, int iterations)
+    {
+        BenchResult result;
+        result.name = benchCase.name;
+        result.ok = false;
+        result.iterations = 0;
+        result.bytes = 0;
+
+        int fds[2];
+        if (pipe(fds) != 0) return result;
+
+        std::cout.flush();
+        const pid_t pid = fork();
+        if (pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            return result;
+        }
+        if (pid == 0)
+        {
+            close(fds[0]);
+            const BenchResult child = runCase(benchCase, root, iterations);
+            std::ostringstream line;
+            line.precision(17);
+            line << child.ok << ' ' << child.iterations << ' ' << child.bytes << ' ' << child.peakRss << ' ' << child.millis.size();
+            for (double ms : child.millis) line << ' ' << ms;
+            const std::string text = line.str();
+            for (size_t written = 0; written < text.size(); )
+            {
+                const ssize_t n = write(fds[1], text.data() + written, text.size() - written);
+                if (n <= 0) break;
+                written += static_cast<size_t>(n);
+            }
+            _exit(0);
+        }
+
+        close(fds[1]);
+        std::string text;
+        char buffer[4096];
+        for (ssize_t n; (n = read(fds[0], buffer, sizeof(buffer))) != 0; )
+        {
+            if (n < 0)
+            {
+                if (errno == EINTR) continue;
+                break;
+            }
+            text.append(buffer, static_cast<size_t>(n));
+        }
+        close(fds[0]);
+
+        int status = 0;
+        while (waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+
+        // A child that crashed leaves nothing to parse and counts as a failure.
+        std::istringstream line(text);
+        size_t count = 0;
+        if (line >> result.ok >> result.iterations >> result.bytes >> result.peakRss >> count)
+        {
+            result.millis.resize(count);
+            for (double& ms : result.millis) line >> ms;
+            result.peakRssKnown = static_cast<bool>(line);
+            result.ok = result.ok && result.peakRssKnown;
+        }
+        else
+        {
+            result.ok = false;
+        }
+        return result;
+    }
+#endif
+
+    void usage()
+    {
+        std::cerr << "Usage: sine_installer_bench [--filter SUBSTRING] [--iterations N] [--out FILE] [--list]\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    std::string filter;
+    std::string outPath;
+    int iterations = 0;
+    bool listOnly = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc)
+        {
+            filter = argv[++i];
+        }
+        else if (arg == "--iterations" && i + 1 < argc)
+        {
+            iterations = std::atoi(argv[++i]);
+        }
+        else if (arg == "--out" && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (arg == "--list")
+        {
+            listOnly = true;
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    std::vector<BenchCase> cases = benchRegistry();
+    std::sort(cases.begin(), cases.end(), [](const BenchCase& a, const BenchCase& b) { return a.name < b.name; });
+
+    if (listOnly)
+    {
+        for (const BenchCase& benchCase : cases) std::cout << benchCase.name << "\n";
+        return 0;
+    }
+
+    const std::filesystem::path root = std::filesystem::temp_directory_path() / "sine-bench";
+    std::vector<BenchResult> results;
+    bool allOk = true;
+
+    const size_t selected = std::count_if(cases.begin(), cases.end(), [&](const BenchCase& benchCase) {
+        return filter.empty() || benchCase.name.find(filter) != std::string::npos;
+    });
+
+    for (const BenchCase& benchCase : cases)
+    {
+        if (!filter.empty() && benchCase.name.find(filter) == std::string::npos) continue;
+
+        std::cerr << benchCase.name << "..." << std::flush;
+#ifdef _WIN32
+        BenchResult result = runCase(benchCase, root, iterations);
+        result.peakRssKnown = selected == 1;
+#else
+        (void)selected;
+        BenchResult result = runIsolated(benchCase, root, iterations);
+#endif
+        std::cerr << (result.ok ? " done\n" : " FAILED\n");
+        allOk = allOk && result.ok;
+        results.push_back(std::move(result));
+    }
+
+    std::error_code ec;
+    std::filesystem::remove_all(root, ec);
+
+    if (outPath.empty())
+    {
+        writeJson(std::cout, results);
+    }
+    else
+    {
+        std::ofstream out(outPath);
+        writeJson(out, results);
+        if (!out)
+        {
+            std::cerr << "Failed to write " << outPath << "\n";
+            return 2;
+        }
+    }
+
+    return allOk ? 0 : 1;
+}
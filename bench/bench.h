@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal benchmark runner for sine_installer_bench. A case prepares its own
+// fixture once, then runs the measured body for a number of iterations; the
+// runner records wall time per iteration and reports percentiles, throughput
+// and the process's peak RSS as JSON.
+
+struct BenchContext
+{
+    // Scratch folder owned by the case, emptied before setup.
+    std::string workDir;
+    // Fixed per case, so fixtures are identical between runs.
+    uint32_t seed;
+};
+
+struct BenchCase
+{
+    std::string name;
+    int iterations;
+    // Builds the fixture. Returns the payload size in bytes processed by one
+    // iteration (0 when throughput is meaningless), or -1 on failure.
+    std::function<int64_t(const BenchContext&)> setup;
+    // One measured iteration. Returns false on failure.
+    std::function<bool(const BenchContext&)> run;
+    // Optional, runs after the last iteration.
+    std::function<void(const BenchContext&)> teardown;
+};
+
+std::vector<BenchCase>& benchRegistry();
+
+// Registers a case from a static initializer in the case's translation unit.
+struct BenchRegistrar
+{
+    explicit BenchRegistrar(BenchCase benchCase);
+};
+
+// Deterministic filler for synthetic fixtures.
+class BenchRandom
+{
+public:
+    explicit BenchRandom(uint32_t seed) : state(seed ? seed : 1) {}
+
+    uint32_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+
+    // Text-like bytes that compress roughly like the browser's JS/CSS files.
+    void fill(std::vector<uint8_t>& buffer);
+
+private:
+    uint32_t state;
+};
+
+// Peak resident set of the whole process so far; it never goes down. The runner
+// therefore gives every case a process of its own on POSIX; on Windows the
+// figure is only reported when a single case runs (--filter).
+size_t peakRssBytes();
@@ -0,0 +1,58 @@
+#include "bench.h"
+#include "http_server.h"
+
+#include <net.h>
+#include <sha256.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// downloadFile() against BenchHttpServer: the large case is dominated by the
+// write callback and hashing, the small one by per-transfer overhead.
+
+namespace
+{
+    std::unique_ptr<BenchHttpServer> server;
+    // Pinned like a release archive, so the digest check is part of the measurement.
+    std::string digest;
+
+    int64_t startServer(const BenchContext& context, size_t size)
+    {
+        std::vector<uint8_t> body(size);
+        BenchRandom(context.seed).fill(body);
+
+        Sha256 hash;
+        hash.update(body.data(), body.size());
+        digest = hash.finishHex();
+
+        server.reset(new BenchHttpServer(std::move(body)));
+        if (!netInit() || !server->start()) return -1;
+        return static_cast<int64_t>(size);
+    }
+
+    bool downloadOnce(const BenchContext& context)
+    {
+        return downloadFile(server->url("/blob.bin"), context.workDir + "/blob.bin", digest);
+    }
+
+    void stopServer(const BenchContext&)
+    {
+        netCleanup();
+        server.reset();
+    }
+
+    BenchRegistrar large({
+        "download/large_64m", 10,
+        [](const BenchContext& context) { return startServer(context, 64 << 20); },
+        downloadOnce,
+        stopServer
+    });
+
+    BenchRegistrar small({
+        "download/small_16k", 200,
+        [](const BenchContext& context) { return startServer(context, 16 << 10); },
+        downloadOnce,
+        stopServer
+    });
+}
@@ -0,0 +1,78 @@
+#include "bench.h"
+
+#include <extract.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <minizip-ng/mz.h>
+#include <minizip-ng/mz_zip.h>
+#include <minizip-ng/mz_zip_rw.h>
+
+// extractZip() on synthetic archives. The real releases mix both shapes:
+// profile.zip is thousands of small chrome/ files, engine.zip a few large ones.
+
+namespace
+{
+    int64_t writeArchive(const BenchContext& context, int files, size_t fileSize)
+    {
+        const std::string zipPath = context.workDir + "/archive.zip";
+        void* writer = mz_zip_writer_create();
+        mz_zip_writer_set_compress_method(writer, MZ_COMPRESS_METHOD_DEFLATE);
+        mz_zip_writer_set_compress_level(writer, MZ_COMPRESS_LEVEL_DEFAULT);
+        if (mz_zip_writer_open_file(writer, zipPath.c_str(), 0, 0) != MZ_OK)
+        {
+            mz_zip_writer_delete(&writer);
+            return -1;
+        }
+
+        BenchRandom random(context.seed);
+        std::vector<uint8_t> data(fileSize);
+        int64_t total = 0;
+        bool ok = true;
+
+        for (int i = 0; ok && i < files; ++i)
+        {
+            random.fill(data);
+            // Spread entries over nested folders, like chrome/JS/... in profile.zip.
+            const std::string name = "chrome/dir" + std::to_string(i % 16) + "/sub" + std::to_string(i % 5)
+                + "/file" + std::to_string(i) + ".js";
+
+            mz_zip_file info = {};
+            info.filename = name.c_str();
+            info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+            info.uncompressed_size = static_cast<int64_t>(data.size());
+            info.modified_date = 0;
+
+            ok = mz_zip_writer_add_buffer(writer, data.data(), static_cast<int32_t>(data.size()), &info) == MZ_OK;
+            total += static_cast<int64_t>(data.size());
+        }
+
+        ok = mz_zip_writer_close(writer) == MZ_OK && ok;
+        mz_zip_writer_delete(&writer);
+        return ok ? total : -1;
+    }
+
+    bool extractOnce(const BenchContext& context)
+    {
+        const std::string outputDir = context.workDir + "/out/";
+        std::error_code ec;
+        std::filesystem::remove_all(outputDir, ec);
+        return extractZip(context.workDir + "/archive.zip", outputDir);
+    }
+
+    BenchRegistrar tinyFiles({
+        "extract/tiny_files_4000x2k", 20,
+        [](const BenchContext& context) { return writeArchive(context, 4000, 2 << 10); },
+        extractOnce,
+        nullptr
+    });
+
+    BenchRegistrar largeFiles({
+        "extract/large_files_4x32m", 10,
+        [](const BenchContext& context) { return writeArchive(context, 4, 32 << 20); },
+        extractOnce,
+        nullptr
+    });
+}
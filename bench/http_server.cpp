@@ -0,0 +1,180 @@
+#include "http_server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+using socket_t = SOCKET;
+#define closeSocket closesocket
+#define SHUT_RDWR SD_BOTH
+#define MSG_NOSIGNAL 0
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using socket_t = int;
+#define closeSocket close
+#endif
+
+BenchHttpServer::BenchHttpServer(std::vector<uint8_t> body) : body(std::move(body))
+{
+}
+
+BenchHttpServer::~BenchHttpServer()
+{
+    stop();
+}
+
+bool BenchHttpServer::start()
+{
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return false;
+#endif
+
+    socket_t sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock == static_cast<socket_t>(-1)) return false;
+
+    int yes = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    socklen_t len = sizeof(addr);
+    if (bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(sock, 16) != 0
+        || getsockname(sock, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+    {
+        closeSocket(sock);
+        return false;
+    }
+
+    listener = static_cast<intptr_t>(sock);
+    port = ntohs(addr.sin_port);
+    running = true;
+    acceptThread = std::thread(&BenchHttpServer::acceptLoop, this);
+    return true;
+}
+
+void BenchHttpServer::stop()
+{
+    if (!running.exchange(false)) return;
+
+    // Unblock accept() with a throwaway connection, then close the listener.
+    socket_t wake = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    connect(wake, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    closeSocket(wake);
+
+    if (acceptThread.joinable()) acceptThread.join();
+    closeSocket(static_cast<socket_t>(listener));
+    listener = -1;
+
+    // Clients may still hold idle keep-alive connections; wake their recv().
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (intptr_t client : clientSockets) shutdown(static_cast<socket_t>(client), SHUT_RDWR);
+    }
+
+    for (std::thread& client : clients)
+    {
+        if (client.joinable()) client.join();
+    }
+    for (intptr_t client : clientSockets) closeSocket(static_cast<socket_t>(client));
+    clients.clear();
+    clientSockets.clear();
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+std::string BenchHttpServer::url(const std::string& path) const
+{
+    return "http://127.0.0.1:" + std::to_string(port) + path;
+}
+
+void BenchHttpServer::acceptLoop()
+{
+    while (running)
+    {
+        socket_t client = accept(static_cast<socket_t>(listener), nullptr, nullptr);
+        if (client == static_cast<socket_t>(-1)) continue;
+        if (!running)
+        {
+            closeSocket(client);
+            break;
+        }
+
+        int yes = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&yes), sizeof(yes));
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clientSockets.push_back(static_cast<intptr_t>(client));
+        clients.emplace_back(&BenchHttpServer::serve, this, static_cast<intptr_t>(client));
+    }
+}
+
+void BenchHttpServer::setDelay(int milliseconds)
+{
+    delayMs = milliseconds;
+}
+
+void BenchHttpServer::serve(intptr_t handle)
+{
+    const socket_t client = static_cast<socket_t>(handle);
+    const std::string header = "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: keep-alive\r\n\r\n";
+    const std::string probeHeader = "HTTP/1.1 206 Partial Content\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "Content-Range: bytes 0-0/" + std::to_string(body.size()) + "\r\n"
+        "Content-Length: 1\r\n"
+        "Connection: keep-alive\r\n\r\n";
+
+    std::string request;
+    char buffer[4096];
+    while (running)
+    {
+        const size_t end = request.find("\r\n\r\n");
+        if (end == std::string::npos)
+        {
+            const int received = static_cast<int>(recv(client, buffer, sizeof(buffer), 0));
+            if (received <= 0) break;
+            request.append(buffer, static_cast<size_t>(received));
+            continue;
+        }
+        const bool probe = request.substr(0, end).find("Range: bytes=0-0") != std::string::npos;
+        request.erase(0, end + 4);
+
+        if (delayMs > 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs.load()));
+        }
+
+        const std::string& head = probe ? probeHeader : header;
+        const size_t length = probe ? std::min<size_t>(body.size(), 1) : body.size();
+        // A client that gave up (a lost mirror race) must not SIGPIPE the process.
+        bool ok = send(client, head.data(), static_cast<int>(head.size()), MSG_NOSIGNAL) == static_cast<int>(head.size());
+        for (size_t sent = 0; ok && sent < length;)
+        {
+            const int chunk = static_cast<int>(std::min<size_t>(length - sent, 1 << 20));
+            const int written = static_cast<int>(send(client, reinterpret_cast<const char*>(body.data()) + sent, chunk, MSG_NOSIGNAL));
+            ok = written > 0;
+            if (ok) sent += static_cast<size_t>(written);
+        }
+        if (!ok) break;
+    }
+}
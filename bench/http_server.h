@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// In-process HTTP/1.1 server on 127.0.0.1 for the download benchmarks. It
+// answers every GET with the same body (or its first byte for a "bytes=0-0"
+// range probe) and keeps connections alive, so downloadFile() is measured
+// without network jitter. A response delay stands in for a distant mirror.
+class BenchHttpServer
+{
+public:
+    explicit BenchHttpServer(std::vector<uint8_t> body);
+    ~BenchHttpServer();
+
+    // Binds an ephemeral port and starts the accept thread.
+    bool start();
+    void stop();
+
+    std::string url(const std::string& path) const;
+
+    // Milliseconds to wait before answering each request.
+    void setDelay(int milliseconds);
+
+private:
+    void acceptLoop();
+    void serve(intptr_t client);
+
+    std::vector<uint8_t> body;
+    intptr_t listener = -1;
+    int port = 0;
+    std::atomic<int> delayMs{ 0 };
+    std::atomic<bool> running{ false };
+    std::thread acceptThread;
+    std::mutex clientsMutex;
+    std::vector<intptr_t> clientSockets;
+    std::vector<std::thread> clients;
+};
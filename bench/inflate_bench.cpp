@@ -0,0 +1,194 @@
+#include "bench.h"
+
+#include <inflate.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <minizip-ng/mz.h>
+#include <minizip-ng/mz_zip.h>
+#include <minizip-ng/mz_zip_rw.h>
+
+// Inflate alone, into memory, once streamed through minizip-ng's zlib and once
+// whole-entry through inflateRaw() (builds with libdeflate only). Point
+// SINE_BENCH_ARCHIVES at a folder holding release archives (program.zip,
+// engine.zip, profile.zip, locales.zip) to measure those; otherwise a synthetic
+// archive shaped like engine.zip stands in.
+
+namespace
+{
+    struct Entry
+    {
+        std::vector<uint8_t> output;
+        std::vector<uint8_t> compressed;
+    };
+
+    std::string archivePath(const BenchContext& context, const std::string& file)
+    {
+        const char* folder = std::getenv("SINE_BENCH_ARCHIVES");
+        return folder ? std::string(folder) + "/" + file : context.workDir + "/" + file;
+    }
+
+    int64_t writeSynthetic(const std::string& zipPath, uint32_t seed)
+    {
+        void* writer = mz_zip_writer_create();
+        mz_zip_writer_set_compress_method(writer, MZ_COMPRESS_METHOD_DEFLATE);
+        mz_zip_writer_set_compress_level(writer, MZ_COMPRESS_LEVEL_DEFAULT);
+        if (mz_zip_writer_open_file(writer, zipPath.c_str(), 0, 0) != MZ_OK)
+        {
+            mz_zip_writer_delete(&writer);
+            return -1;
+        }
+
+        // A couple of large libraries next to many small scripts.
+        BenchRandom random(seed);
+        bool ok = true;
+        for (int i = 0; ok && i < 402; ++i)
+        {
+            std::vector<uint8_t> data(i < 2 ? 24 << 20 : 24 << 10);
+            random.fill(data);
+            const std::string name = "engine/file" + std::to_string(i);
+
+            mz_zip_file info = {};
+            info.filename = name.c_str();
+            info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+            info.uncompressed_size = static_cast<int64_t>(data.size());
+            ok = mz_zip_writer_add_buffer(writer, data.data(), static_cast<int32_t>(data.size()), &info) == MZ_OK;
+        }
+
+        ok = mz_zip_writer_close(writer) == MZ_OK && ok;
+        mz_zip_writer_delete(&writer);
+        return ok ? 0 : -1;
+    }
+
+    // Uncompressed bytes of the deflated entries, which is all either side inflates.
+    int64_t deflatedBytes(const std::string& zipPath)
+    {
+        void* reader = mz_zip_reader_create();
+        int64_t total = -1;
+        if (mz_zip_reader_open_file(reader, zipPath.c_str()) == MZ_OK)
+        {
+            total = 0;
+            if (mz_zip_reader_goto_first_entry(reader) == MZ_OK)
+            {
+                do
+                {
+                    mz_zip_file* info = nullptr;
+                    if (mz_zip_reader_entry_get_info(reader, &info) == MZ_OK
+                        && info->compression_method == MZ_COMPRESS_METHOD_DEFLATE)
+                    {
+                        total += info->uncompressed_size;
+                    }
+                } while (mz_zip_reader_goto_next_entry(reader) == MZ_OK);
+            }
+            mz_zip_reader_close(reader);
+        }
+        mz_zip_reader_delete(&reader);
+        return total;
+    }
+
+    bool inflateEntry(void* reader, const mz_zip_file* info, bool whole, Entry& entry)
+    {
+        entry.output.resize(static_cast<size_t>(info->uncompressed_size));
+        if (entry.output.empty()) return true;
+
+        if (!whole)
+        {
+            if (mz_zip_reader_entry_open(reader) != MZ_OK) return false;
+            int64_t total = 0;
+            while (total < info->uncompressed_size)
+            {
+                const int32_t got = mz_zip_reader_entry_read(reader, entry.output.data() + total,
+                    static_cast<int32_t>(info->uncompressed_size - total));
+                if (got <= 0) break;
+                total += got;
+            }
+            mz_zip_reader_entry_close(reader);
+            return total == info->uncompressed_size;
+        }
+
+        // Reading the raw bytes is part of the whole-entry path's cost, as in extraction.
+        void* zip = nullptr;
+        mz_zip_reader_get_zip_handle(reader, &zip);
+        if (mz_zip_entry_read_open(zip, 1, nullptr) != MZ_OK) return false;
+        entry.compressed.resize(static_cast<size_t>(info->compressed_size));
+        int64_t total = 0;
+        while (total < info->compressed_size)
+        {
+            const int32_t got = mz_zip_entry_read(zip, entry.compressed.data() + total,
+                static_cast<int32_t>(info->compressed_size - total));
+            if (got <= 0) break;
+            total += got;
+        }
+        mz_zip_entry_close(zip);
+        return total == info->compressed_size
+            && inflateRaw(entry.compressed.data(), entry.compressed.size(), entry.output.data(), entry.output.size());
+    }
+
+    bool inflateArchive(const std::string& zipPath, bool whole)
+    {
+        void* reader = mz_zip_reader_create();
+        bool ok = mz_zip_reader_open_file(reader, zipPath.c_str()) == MZ_OK
+            && mz_zip_reader_goto_first_entry(reader) == MZ_OK;
+
+        Entry entry;
+        while (ok)
+        {
+            mz_zip_file* info = nullptr;
+            ok = mz_zip_reader_entry_get_info(reader, &info) == MZ_OK;
+            if (ok && info->compression_method == MZ_COMPRESS_METHOD_DEFLATE)
+            {
+                ok = inflateEntry(reader, info, whole, entry);
+            }
+            if (mz_zip_reader_goto_next_entry(reader) != MZ_OK) break;
+        }
+
+        mz_zip_reader_close(reader);
+        mz_zip_reader_delete(&reader);
+        return ok;
+    }
+
+    void registerArchive(const std::string& file)
+    {
+        const std::string stem = file.substr(0, file.find('.'));
+        const bool synthetic = !std::getenv("SINE_BENCH_ARCHIVES");
+
+        auto setup = [file, synthetic](const BenchContext& context) -> int64_t {
+            const std::string path = archivePath(context, file);
+            if (synthetic && writeSynthetic(path, context.seed) < 0) return -1;
+            return deflatedBytes(path);
+        };
+
+        BenchRegistrar({ "inflate/" + stem + "_minizip", 10, setup,
+            [file](const BenchContext& context) { return inflateArchive(archivePath(context, file), false); },
+            nullptr });
+
+#ifdef SINE_HAVE_LIBDEFLATE
+        BenchRegistrar({ "inflate/" + stem + "_libdeflate", 10, setup,
+            [file](const BenchContext& context) { return inflateArchive(archivePath(context, file), true); },
+            nullptr });
+#endif
+    }
+
+    struct RegisterArchives
+    {
+        RegisterArchives()
+        {
+            const char* folder = std::getenv("SINE_BENCH_ARCHIVES");
+            if (!folder)
+            {
+                registerArchive("synthetic_engine.zip");
+                return;
+            }
+            for (const char* file : { "program.zip", "engine.zip", "profile.zip", "locales.zip" })
+            {
+                if (std::filesystem::exists(std::string(folder) + "/" + file))
+                {
+                    registerArchive(file);
+                }
+            }
+        }
+    } registerArchives;
+}
@@ -0,0 +1,61 @@
+#include "bench.h"
+#include "http_server.h"
+
+#include <mirrors.h>
+#include <net.h>
+#include <sha256.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+// downloadFromCandidates() against three local stand-ins for mirrors that answer
+// after 150, 60 and 0 ms. The fastest is listed last, so an iteration that takes
+// much more than one probe round trip plus the transfer picked the wrong mirror.
+
+namespace
+{
+    std::vector<std::unique_ptr<BenchHttpServer>> servers;
+    std::vector<std::string> candidates;
+    std::string digest;
+
+    int64_t startServers(const BenchContext& context)
+    {
+        std::vector<uint8_t> body(4 << 20);
+        BenchRandom(context.seed).fill(body);
+
+        Sha256 hash;
+        hash.update(body.data(), body.size());
+        digest = hash.finishHex();
+
+        if (!netInit()) return -1;
+        for (int delay : { 150, 60, 0 })
+        {
+            servers.emplace_back(new BenchHttpServer(body));
+            servers.back()->setDelay(delay);
+            if (!servers.back()->start()) return -1;
+            candidates.push_back(servers.back()->url("/engine.zip"));
+        }
+        return static_cast<int64_t>(body.size());
+    }
+
+    bool downloadOnce(const BenchContext& context)
+    {
+        return downloadFromCandidates(candidates, context.workDir + "/engine.zip", digest);
+    }
+
+    void stopServers(const BenchContext&)
+    {
+        netCleanup();
+        servers.clear();
+        candidates.clear();
+    }
+
+    BenchRegistrar race({
+        "download/mirror_race_3",
+        20,
+        startServers,
+        downloadOnce,
+        stopServers
+    });
+}
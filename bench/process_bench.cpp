@@ -0,0 +1,24 @@
+#include "bench.h"
+
+#include <platform.h>
+
+#include <string>
+
+// isProcessRunning() guards the browser-closed check in the wizard and walks
+// every process on the system, so it scales with the machine, not the installer.
+
+namespace
+{
+#ifdef _WIN32
+    const char* missingProcess = "sine-bench-not-running.exe";
+#else
+    const char* missingProcess = "sine-bench-not-running";
+#endif
+
+    BenchRegistrar missing({
+        "process/is_running_missing", 50,
+        [](const BenchContext&) { return int64_t(0); },
+        [](const BenchContext&) { return !isProcessRunning(missingProcess); },
+        nullptr
+    });
+}
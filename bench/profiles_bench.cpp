@@ -0,0 +1,57 @@
+#include "bench.h"
+
+#include <profiles.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// The profile list in State::FOUR is rebuilt on every frame, so its cost is
+// paid at the display refresh rate while that screen is open.
+
+namespace
+{
+    int64_t writeProfiles(const BenchContext& context, int profiles, int filesPerProfile)
+    {
+        BenchRandom random(context.seed);
+        std::error_code ec;
+
+        for (int i = 0; i < profiles; ++i)
+        {
+            const std::filesystem::path profile = std::filesystem::path(context.workDir)
+                / (std::to_string(random.next() % 100000000) + ".profile" + std::to_string(i));
+            std::filesystem::create_directories(profile, ec);
+            if (ec) return -1;
+
+            // prefs.js lands at a random position in directory order, and only
+            // three quarters of the profiles have been used.
+            const int prefsAt = (random.next() & 3) ? static_cast<int>(random.next() % filesPerProfile) : -1;
+            for (int j = 0; j < filesPerProfile; ++j)
+            {
+                const std::string name = j == prefsAt ? "prefs.js" : "file" + std::to_string(j) + ".sqlite";
+                std::ofstream(profile / name) << name;
+            }
+        }
+
+        return 0;
+    }
+
+    bool scanOnce(const BenchContext& context)
+    {
+        return !listProfiles(context.workDir, false).empty();
+    }
+
+    BenchRegistrar fewProfiles({
+        "profiles/scan_4x60", 200,
+        [](const BenchContext& context) { return writeProfiles(context, 4, 60); },
+        scanOnce,
+        nullptr
+    });
+
+    BenchRegistrar manyProfiles({
+        "profiles/scan_64x60", 50,
+        [](const BenchContext& context) { return writeProfiles(context, 64, 60); },
+        scanOnce,
+        nullptr
+    });
+}
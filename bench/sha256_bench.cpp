@@ -0,0 +1,54 @@
+#include <sha256.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+using namespace std::chrono;
+
+// Hashes a buffer in download-sized chunks, the way writeData() sees it.
+static double measure(const std::vector<uint8_t>& data, size_t chunk, int rounds)
+{
+    double best = 0.0;
+    for (int r = 0; r < rounds; ++r)
+    {
+        auto begin = steady_clock::now();
+        Sha256 hash;
+        for (size_t off = 0; off < data.size(); off += chunk)
+        {
+            hash.update(data.data() + off, std::min(chunk, data.size() - off));
+        }
+        volatile uint8_t sink = hash.finish()[0];
+        (void)sink;
+        double seconds = duration<double>(steady_clock::now() - begin).count();
+        double mbps = data.size() / (1024.0 * 1024.0) / seconds;
+        if (mbps > best) best = mbps;
+    }
+    return best;
+}
+
+int main()
+{
+    std::vector<uint8_t> data(64 << 20);
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<uint8_t>(i * 2654435761u >> 13);
+    }
+
+    const size_t chunks[] = { 1 << 10, 16 << 10, 256 << 10 };
+    for (size_t chunk : chunks)
+    {
+        Sha256::forceScalar(false);
+        const char* backend = Sha256::backend();
+        double fast = measure(data, chunk, 5);
+
+        Sha256::forceScalar(true);
+        double scalar = measure(data, chunk, 5);
+
+        std::printf("chunk %7zu B: %-7s %8.1f MB/s, scalar %8.1f MB/s (x%.2f)\n",
+            chunk, backend, fast, scalar, fast / scalar);
+    }
+
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <agent.h>
+#include <data.h>
+#include <install.h>
+#include <net.h>
+#include <platform.h>
+#include <profiles.h>
+#include <progress.h>
+#include <trace.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // A remote manifest is kept here between checks, next to its validators.
+    const char* manifestName = "sine-release.txt";
+
+    // Timestamped, as the agent's output usually ends up in a log.
+    std::ostream& log(std::ostream& out)
+    {
+        const std::time_t now = std::time(nullptr);
+        char stamp[32];
+        std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&now));
+        return out << stamp << "  ";
+    }
+
+    int64_t millisecondsUntil(Clock::time_point when)
+    {
+        return std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(when - Clock::now()).count());
+    }
+
+    // Versions end up in release URLs, file names and prefs.js, so the manifest gets no say in their syntax.
+    bool isVersion(const std::string& version)
+    {
+        return !version.empty() && version.find("..") == std::string::npos
+            && std::all_of(version.begin(), version.end(), [](unsigned char c) {
+                return std::isalnum(c) || c == '.' || c == '+' || c == '-';
+            });
+    }
+
+    bool isDigest(const std::string& digest)
+    {
+        return digest.size() == 64 && std::all_of(digest.begin(), digest.end(), [](unsigned char c) {
+            return std::isdigit(c) || (c >= 'a' && c <= 'f');
+        });
+    }
+
+    bool readRelease(const std::string& path, Release& release)
+    {
+        std::ifstream file(path, std::ios::binary);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+
+            if (line.rfind("boot ", 0) == 0) release.boot = line.substr(5);
+            else if (line.rfind("sine ", 0) == 0) release.sine = line.substr(5);
+            else if (line.rfind("sha256 ", 0) == 0)
+            {
+                // "sha256 engine.zip <hex>"
+                const size_t space = line.find(' ', 7);
+                if (space == std::string::npos) return false;
+                const std::string name = line.substr(7, space - 7);
+                const std::string digest = line.substr(space + 1);
+                if (!isDigest(digest)) return false;
+                release.digests[name] = digest;
+            }
+        }
+        return isVersion(release.boot) && isVersion(release.sine);
+    }
+
+    // Makes the endpoint's release the one to install. A failed check keeps the
+    // release of the last one that went through.
+    void checkEndpoint(const AgentOptions& options, Release& current)
+    {
+        TraceSpan span("check", "agent", options.endpoint);
+
+        std::string path = options.endpoint;
+        if (options.endpoint.find("://") != std::string::npos)
+        {
+            path = options.downloadsFolder + "/" + manifestName;
+            if (!downloadFile(options.endpoint, path))
+            {
+                log(std::cerr) << "Could not fetch " << options.endpoint << ".\n";
+                return;
+            }
+        }
+
+        Release release;
+        if (!readRelease(path, release))
+        {
+            log(std::cerr) << path << " names no valid release.\n";
+            return;
+        }
+
+        // The compiled-in digests still hold for archives of a compiled-in version.
+        const Release& compiled = compiledRelease();
+        for (const auto& [name, digest] : compiled.digests)
+        {
+            const bool boot = name == "program.zip" || name == "profile.zip";
+            if (boot ? release.boot == compiled.boot : release.sine == compiled.sine)
+            {
+                release.digests.emplace(name, digest);
+            }
+        }
+
+        // Anything else is installed unattended, from an endpoint that may well be
+        // plain http, so the manifest has to vouch for every archive of it.
+        if (release.boot != compiled.boot || release.sine != compiled.sine)
+        {
+            for (const char* archive : { "program.zip", "profile.zip", "engine.zip", "locales.zip" })
+            {
+                if (release.digests.count(archive) == 0)
+                {
+                    log(std::cerr) << path << " lists no sha256 for " << archive << "; release ignored.\n";
+                    return;
+                }
+            }
+        }
+
+        if (release.boot != current.boot || release.sine != current.sine)
+        {
+            log(reportStream()) << "Release is now bootloader " << release.boot << ", Sine " << release.sine << ".\n";
+        }
+        current = release;
+    }
+
+    // The browser the profile belongs to, by where its profiles live; every known one when that is unclear.
+    std::vector<std::string> browserProcesses(const std::string& profilePath)
+    {
+        const std::string profile = std::filesystem::path(profilePath).lexically_normal().string();
+        std::vector<std::string> owners;
+        std::vector<std::string> all;
+        for (size_t browser = 0; browser < browsers.size(); ++browser)
+        {
+            std::string name = browsers[browser].first;
+            std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+            if (getOS() == "win32") name += ".exe";
+
+            const std::string root = std::filesystem::path(getProfileLocation(static_cast<int>(browser))).lexically_normal().string();
+            if (profile.rfind(root, 0) == 0) owners.push_back(name);
+            all.push_back(name);
+        }
+        return owners.empty() ? all : owners;
+    }
+
+    // Everything short of touching what is live: downloads the archives and extracts the profile into staging.
+    bool stage(const AgentOptions& options, const Release& release, bool browserDue, bool profileDue)
+    {
+        TraceSpan span("stage", "agent");
+
+        std::vector<std::string> archives;
+        if (browserDue)
+        {
+            archives.push_back("program.zip");
+        }
+        if (profileDue)
+        {
+            archives.insert(archives.end(), { "profile.zip", "engine.zip", "locales.zip" });
+        }
+
+        if (!options.offline)
+        {
+            for (const std::string& archive : archives)
+            {
+                if (!downloadArchive(options.downloadsFolder, archive, release))
+                {
+                    log(std::cerr) << "Failed to download or verify " << archive << ".\n";
+                    return false;
+                }
+            }
+        }
+
+        std::string error;
+        if (profileDue && !stageProfile(options.downloadsFolder, options.profilePath, error))
+        {
+            log(std::cerr) << error << "\n";
+            progressError("install", 0, options.profilePath + ": " + error);
+            return false;
+        }
+
+        log(reportStream()) << "Staged bootloader " << release.boot << ", Sine " << release.sine << ".\n";
+        return true;
+    }
+
+    // Runs once the browser is closed; only the swap and prefs.js are left for the profile.
+    bool apply(const AgentOptions& options, const Release& release, bool browserDue, bool profileDue)
+    {
+        TraceSpan span("apply", "agent");
+        const auto begin = Clock::now();
+
+        bool ok = true;
+        if (browserDue)
+        {
+            if (extractArchive(options.downloadsFolder, "program.zip", options.browserPath))
+            {
+                writeBrowserStamp(options.browserPath, release);
+            }
+            else
+            {
+                log(std::cerr) << "Failed to extract program.zip into " << options.browserPath << ".\n";
+                ok = false;
+            }
+        }
+
+        if (profileDue)
+        {
+            std::string error;
+            if (commitProfile(options.profilePath, error, release))
+            {
+                if (!options.saveData)
+                {
+                    removeMods(options.profilePath);
+                }
+                clearStartupCache(options.profilePath);
+            }
+            else
+            {
+                log(std::cerr) << error << "\n";
+                progressError("install", 0, options.profilePath + ": " + error);
+                ok = false;
+            }
+        }
+
+        if (!options.offline)
+        {
+            pruneArchives(options.downloadsFolder, release);
+        }
+
+        if (ok)
+        {
+            const double ms = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+            log(reportStream()) << "Updated to bootloader " << release.boot << ", Sine " << release.sine
+                << " in " << static_cast<int64_t>(ms) << " ms.\n";
+        }
+        return ok;
+    }
+}
+
+void runAgent(const AgentOptions& options)
+{
+    Release current = compiledRelease();
+    const std::vector<std::string> processes = browserProcesses(options.profilePath);
+    const auto interval = std::chrono::minutes(std::max<int64_t>(1, options.intervalMinutes));
+
+    // The agent is killed rather than stopped, so every line goes out as it is written.
+    reportStream() << std::unitbuf;
+
+    log(reportStream()) << "Keeping " << options.profilePath << " current, checking "
+        << (options.endpoint.empty() ? "the compiled-in release" : options.endpoint)
+        << " every " << interval.count() << " min.\n";
+
+    // "<boot> <sine>" of what is staged, empty when nothing is.
+    std::string staged;
+    for (;;)
+    {
+        const Clock::time_point nextCheck = Clock::now() + interval;
+        if (!options.endpoint.empty())
+        {
+            checkEndpoint(options, current);
+        }
+
+        const bool browserDue = !options.browserPath.empty() && !browserUpToDate(options.browserPath, current);
+        const bool profileDue = !profileUpToDate(options.profilePath, current);
+        if (browserDue || profileDue)
+        {
+            const std::string release = current.boot + " " + current.sine;
+            if (staged != release || (profileDue && !profileStaged(options.profilePath)))
+            {
+                staged = stage(options, current, browserDue, profileDue) ? release : "";
+            }
+
+            // Until the next check at the latest, which may bring a newer release to stage instead.
+            if (!staged.empty() && waitForProcessExit(processes, millisecondsUntil(nextCheck)))
+            {
+                apply(options, current, browserDue, profileDue);
+                staged.clear();
+            }
+        }
+
+        std::this_thread::sleep_until(nextCheck);
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+struct AgentOptions
+{
+    std::string profilePath;
+    // When set, program.zip is kept current in this browser folder too.
+    std::string browserPath;
+    std::string downloadsFolder;
+    // A release manifest, as a local path or a URL; without one the agent keeps
+    // the profile at the versions compiled into the installer.
+    std::string endpoint;
+    int64_t intervalMinutes = 360;
+    // Archives come from the executable's payload instead of the network.
+    bool offline = false;
+    bool saveData = false;
+};
+
+// Headless --agent mode: stays resident without a window and wakes on a timer to
+// check the release endpoint (a conditional request, so an unchanged release costs
+// a 304). The manifest names the release like a profile stamp does, with the
+// digests of its archives:
+//
+//   boot 0.1.2
+//   sine 2.4
+//   sha256 engine.zip 9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08
+//
+// Versions may only use [0-9A-Za-z.+-] and digests lowercase hex; a manifest with
+// anything else is ignored. So is one naming a release other than the compiled-in
+// one without a digest for each of program.zip, profile.zip, engine.zip and
+// locales.zip; the compiled-in release is checked as everywhere else.
+//
+// When the profile (or browser) is behind, the archives are downloaded and the
+// profile is staged right away, while the browser is still open. The agent then
+// sleeps on the browser's processes and commits the staged install the moment the
+// last one exits, or right away when the browser is not running. Runs until killed.
+[[noreturn]] void runAgent(const AgentOptions& options);
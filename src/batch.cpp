@@ -0,0 +1,439 @@
+#include <batch.h>
+#include <data.h>
+#include <install.h>
+#include <net.h>
+#include <platform.h>
+#include <profiles.h>
+#include <progress.h>
+#include <trace.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    struct BatchTarget
+    {
+        std::string browser;
+        std::string profilePath;
+        bool current = false;
+        bool ok = false;
+        double ms = 0.0;
+        std::string error;
+    };
+
+    std::vector<BatchTarget> findTargets(bool allUsers)
+    {
+        std::vector<std::string> homes;
+        if (allUsers)
+        {
+            homes = listUserHomes();
+        }
+
+        std::vector<BatchTarget> targets;
+        for (size_t browser = 0; browser < browsers.size(); ++browser)
+        {
+            std::vector<std::string> roots;
+            if (allUsers)
+            {
+                for (const std::string& home : homes)
+                {
+                    roots.push_back(getProfileLocation(static_cast<int>(browser), home));
+                }
+            }
+            else
+            {
+                roots.push_back(getProfileLocation(static_cast<int>(browser)));
+            }
+
+            for (const std::string& root : roots)
+            {
+                std::error_code ec;
+                if (!std::filesystem::is_directory(root, ec)) continue;
+
+                std::vector<std::string> profiles;
+                try
+                {
+                    profiles = listProfiles(root, false);
+                }
+                catch (const std::filesystem::filesystem_error& e)
+                {
+                    std::cerr << "Skipping " << root << ": " << e.what() << "\n";
+                    continue;
+                }
+
+                for (const std::string& profile : profiles)
+                {
+                    BatchTarget target;
+                    target.browser = browsers[browser].first;
+                    target.profilePath = (std::filesystem::path(root) / profile).string();
+
+                    // Browsers sharing a profile folder would otherwise get it twice.
+                    bool seen = std::any_of(targets.begin(), targets.end(),
+                        [&](const BatchTarget& t) { return t.profilePath == target.profilePath; });
+                    if (!seen) targets.push_back(target);
+                }
+            }
+        }
+
+        return targets;
+    }
+
+    // The same steps the wizard runs for one profile, minus the downloads.
+    void installProfile(const BatchOptions& options, BatchTarget& target)
+    {
+        try
+        {
+            const std::filesystem::path chrome = std::filesystem::path(target.profilePath) / "chrome";
+            std::filesystem::create_directories(chrome);
+
+            target.ok = configureProfile(options.downloadsFolder, target.profilePath, target.error);
+            // A failed install left the previous version in place, which still wants its mods.
+            if (target.ok)
+            {
+                if (!options.saveData)
+                {
+                    removeMods(target.profilePath);
+                }
+                clearStartupCache(target.profilePath);
+            }
+
+            matchOwnership(chrome.string(), target.profilePath);
+            matchOwnership((std::filesystem::path(target.profilePath) / "prefs.js").string(), target.profilePath);
+        }
+        catch (const std::filesystem::filesystem_error& e)
+        {
+            target.ok = false;
+            target.error = e.what();
+        }
+    }
+
+    void reportFailure(const BatchTarget& target)
+    {
+        if (!target.ok)
+        {
+            progressError("install", 0, target.profilePath + ": " + target.error);
+        }
+    }
+
+    void installTarget(const BatchOptions& options, BatchTarget& target)
+    {
+        TraceSpan span("profile", "batch", target.profilePath);
+        const auto begin = std::chrono::steady_clock::now();
+        installProfile(options, target);
+        target.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+        reportFailure(target);
+    }
+
+#ifndef _WIN32
+    // --all-users runs as root over folders that belong to other users, who can
+    // rearrange them while it works: a chrome/ or .sine-staging that is a symlink,
+    // a planted prefs.js.sine-tmp. So each of those profiles is installed by a child
+    // process that has become the profile's owner first and can write nothing that
+    // user could not. The children are forked from the main thread alone, with no
+    // worker holding a lock, and read the archives from memory (holdArchives()),
+    // since root's cache folder is closed to them.
+    struct OwnerChild
+    {
+        pid_t pid = -1;
+        int pipe = -1;
+        size_t n = 0;
+        std::chrono::steady_clock::time_point begin;
+        int64_t traceStart = 0;
+    };
+
+    bool startAsOwner(const BatchOptions& options, BatchTarget& target, OwnerChild& child)
+    {
+        int fds[2];
+        if (pipe(fds) != 0) return false;
+
+        // Whatever is still buffered would otherwise be written twice.
+        std::cout.flush();
+        std::cerr.flush();
+        fflush(nullptr);
+
+        child.pid = fork();
+        if (child.pid < 0)
+        {
+            close(fds[0]);
+            close(fds[1]);
+            return false;
+        }
+
+        if (child.pid == 0)
+        {
+            close(fds[0]);
+            if (becomeOwnerOf(target.profilePath, target.error))
+            {
+                installProfile(options, target);
+            }
+            else
+            {
+                target.ok = false;
+            }
+
+            // Kept well below a pipe's buffer, so the child never waits on the parent.
+            const std::string message = (target.ok ? "1" : "0") + target.error.substr(0, 2048);
+            for (size_t done = 0; done < message.size();)
+            {
+                const ssize_t n = write(fds[1], message.data() + done, message.size() - done);
+                if (n < 0 && errno == EINTR) continue;
+                if (n <= 0) break;
+                done += static_cast<size_t>(n);
+            }
+            std::cout.flush();
+            std::cerr.flush();
+            fflush(nullptr);
+            _exit(0);
+        }
+
+        close(fds[1]);
+        child.pipe = fds[0];
+        return true;
+    }
+
+    void finishAsOwner(OwnerChild& child, int status, BatchTarget& target)
+    {
+        std::string message;
+        char buffer[4096];
+        for (;;)
+        {
+            const ssize_t n = read(child.pipe, buffer, sizeof(buffer));
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            message.append(buffer, static_cast<size_t>(n));
+        }
+        close(child.pipe);
+
+        const bool exited = WIFEXITED(status) && WEXITSTATUS(status) == 0 && !message.empty();
+        target.ok = exited && message[0] == '1';
+        target.error = exited ? message.substr(1) : "The install process for this profile failed.";
+    }
+
+    void installAsOwners(const BatchOptions& options, std::vector<BatchTarget>& targets,
+        const std::vector<size_t>& pending, unsigned jobs)
+    {
+        std::vector<OwnerChild> running;
+        size_t next = 0;
+        while (next < pending.size() || !running.empty())
+        {
+            while (next < pending.size() && running.size() < jobs)
+            {
+                BatchTarget& target = targets[pending[next]];
+                progressStepStart(next, pending.size(), target.profilePath.c_str());
+
+                OwnerChild child;
+                child.n = next++;
+                child.begin = std::chrono::steady_clock::now();
+                child.traceStart = traceNow();
+                if (startAsOwner(options, target, child))
+                {
+                    running.push_back(child);
+                    continue;
+                }
+
+                target.ok = false;
+                target.error = std::string("Failed to start an install process: ") + std::strerror(errno);
+                reportFailure(target);
+                progressStepEnd(child.n, pending.size(), target.profilePath.c_str(), false, 0.0);
+            }
+            if (running.empty()) continue;
+
+            int status = 0;
+            const pid_t pid = waitpid(-1, &status, 0);
+            if (pid < 0)
+            {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            auto child = std::find_if(running.begin(), running.end(), [pid](const OwnerChild& c) { return c.pid == pid; });
+            if (child == running.end()) continue;
+
+            BatchTarget& target = targets[pending[child->n]];
+            finishAsOwner(*child, status, target);
+            target.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - child->begin).count();
+            traceEvent("profile", "batch", child->traceStart, traceNow() - child->traceStart, target.profilePath.c_str());
+            reportFailure(target);
+            progressStepEnd(child->n, pending.size(), target.profilePath.c_str(), target.ok, target.ms);
+            running.erase(child);
+        }
+    }
+#endif
+
+    void printReport(const std::vector<BatchTarget>& targets)
+    {
+        std::ostringstream report;
+        report << std::fixed << std::setprecision(0);
+        for (const BatchTarget& target : targets)
+        {
+            report << std::left << std::setw(7) << (target.current ? "current" : target.ok ? "ok" : "FAIL")
+                << ' ' << std::right << std::setw(8) << target.ms << " ms  "
+                << std::left << std::setw(10) << target.browser << ' ' << target.profilePath
+                << (target.error.empty() ? "" : "  ") << target.error << '\n';
+        }
+        reportStream() << report.str();
+    }
+}
+
+int runBatchInstall(const BatchOptions& options)
+{
+    const auto begin = std::chrono::steady_clock::now();
+
+    std::vector<BatchTarget> targets = findTargets(options.allUsers);
+    if (targets.empty())
+    {
+        std::cerr << "No profiles found.\n";
+        return 2;
+    }
+
+    // Profiles (and the browser) already at the compiled-in versions are left alone,
+    // so a no-op fleet update costs a few stat() calls per profile.
+    std::vector<size_t> pending;
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        targets[i].current = !options.force && profileUpToDate(targets[i].profilePath);
+        targets[i].ok = targets[i].current;
+        if (!targets[i].current) pending.push_back(i);
+    }
+    const bool installBrowser = !options.browserPath.empty() && (options.force || !browserUpToDate(options.browserPath));
+
+    reportStream() << "Installing into " << pending.size() << " of " << targets.size() << " profile"
+        << (targets.size() == 1 ? "" : "s") << (installBrowser ? " and the browser" : "") << ".\n";
+
+    std::vector<std::string> archives;
+    if (installBrowser)
+    {
+        archives.push_back("program.zip");
+    }
+    if (!pending.empty())
+    {
+        archives.insert(archives.end(), { "profile.zip", "engine.zip", "locales.zip" });
+    }
+
+    // Everything is fetched and verified once, up front, before any profile is touched.
+    if (!options.offline)
+    {
+        for (size_t i = 0; i < archives.size(); ++i)
+        {
+            const std::string step = "Downloading " + archives[i] + "...";
+            const auto stepBegin = std::chrono::steady_clock::now();
+            progressStepStart(i, archives.size(), step.c_str());
+
+            const bool ok = downloadArchive(options.downloadsFolder, archives[i]);
+            progressStepEnd(i, archives.size(), step.c_str(), ok,
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepBegin).count());
+            if (!ok)
+            {
+                std::cerr << "Failed to download or verify " << archives[i] << ".\n";
+                pruneArchives(options.downloadsFolder);
+                progressDone(false, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count(),
+                    getTransferStats().transfers, getTransferStats().bytesReceived);
+                return 2;
+            }
+        }
+    }
+
+    int failures = 0;
+    if (installBrowser)
+    {
+        if (extractArchive(options.downloadsFolder, "program.zip", options.browserPath))
+        {
+            writeBrowserStamp(options.browserPath);
+        }
+        else
+        {
+            std::cerr << "Failed to extract program.zip into " << options.browserPath << ".\n";
+            ++failures;
+        }
+    }
+
+    unsigned jobs = options.jobs;
+    if (jobs == 0)
+    {
+        jobs = std::min(8u, std::max(1u, std::thread::hardware_concurrency()));
+    }
+    jobs = std::min<unsigned>(jobs, static_cast<unsigned>(pending.size()));
+
+#ifndef _WIN32
+    if (options.allUsers && geteuid() == 0 && !pending.empty())
+    {
+        if (!holdArchives(options.downloadsFolder, { "profile.zip", "engine.zip", "locales.zip" }))
+        {
+            for (size_t n : pending)
+            {
+                targets[n].error = "The archives could not be read.";
+                reportFailure(targets[n]);
+            }
+        }
+        else
+        {
+            installAsOwners(options, targets, pending, jobs);
+        }
+        // Nothing is left for the workers.
+        pending.clear();
+        jobs = 0;
+    }
+#endif
+
+    // Workers pull the next target off a shared counter, so a slow profile
+    // doesn't hold up a fixed share of the others.
+    std::atomic<size_t> next{ 0 };
+    auto worker = [&]()
+    {
+        for (size_t n = next++; n < pending.size(); n = next++)
+        {
+            BatchTarget& target = targets[pending[n]];
+            progressStepStart(n, pending.size(), target.profilePath.c_str());
+            installTarget(options, target);
+            progressStepEnd(n, pending.size(), target.profilePath.c_str(), target.ok, target.ms);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned i = 1; i < jobs; ++i)
+    {
+        pool.emplace_back(worker);
+    }
+    if (jobs > 0)
+    {
+        worker();
+    }
+    for (std::thread& thread : pool)
+    {
+        thread.join();
+    }
+
+    if (!options.offline && !archives.empty())
+    {
+        pruneArchives(options.downloadsFolder);
+    }
+
+    printReport(targets);
+
+    const size_t installed = std::count_if(targets.begin(), targets.end(), [](const BatchTarget& t) { return t.ok; });
+    failures += static_cast<int>(targets.size() - installed);
+
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+    reportStream() << installed << " of " << targets.size() << " profiles current after "
+        << static_cast<int64_t>(ms + 0.5) << " ms.\n";
+
+    const TransferStats transfers = getTransferStats();
+    progressDone(failures == 0, ms, transfers.transfers, transfers.bytesReceived);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+struct BatchOptions
+{
+    // Every profile (with a prefs.js) of every known browser for the current user,
+    // or for every local user with allUsers. Run as root on POSIX, allUsers installs
+    // each profile from a child process that has become the profile's owner.
+    bool allUsers = false;
+    bool saveData = false;
+    // When set, program.zip is installed into this browser folder once.
+    std::string browserPath;
+    std::string downloadsFolder;
+    // Archives come from the executable's payload instead of the network.
+    bool offline = false;
+    // Reinstall even where the version stamps say everything is current.
+    bool force = false;
+    // Worker threads for the per-profile work; 0 picks one per core, at most 8.
+    unsigned jobs = 0;
+};
+
+// Headless --all-profiles / --all-users install: skips profiles that are already
+// current, downloads and verifies each archive still needed once, then installs
+// into the remaining profiles on a bounded worker pool and prints one result
+// line per target. Returns 0 when every target succeeded,
+// 1 when any failed and 2 when nothing could be installed.
+int runBatchInstall(const BatchOptions& options);
@@ -0,0 +1,244 @@
+#include <crc32.h>
+
+#include <cstdio>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SINE_CRC_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SINE_TARGET_CLMUL
+#else
+#include <cpuid.h>
+#define SINE_TARGET_CLMUL __attribute__((target("pclmul,sse4.1")))
+#endif
+#elif defined(__ARM_FEATURE_CRC32)
+#define SINE_CRC_ARM 1
+#include <arm_acle.h>
+#endif
+
+namespace
+{
+    struct Tables
+    {
+        uint32_t t[8][256];
+
+        Tables()
+        {
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                {
+                    c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+                }
+                t[0][i] = c;
+            }
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                for (int s = 1; s < 8; ++s)
+                {
+                    t[s][i] = (t[s - 1][i] >> 8) ^ t[0][t[s - 1][i] & 0xff];
+                }
+            }
+        }
+    };
+
+    const Tables tables;
+
+    // Operates on the raw (non-inverted) register.
+    uint32_t crcScalar(uint32_t crc, const uint8_t* p, size_t len)
+    {
+        while (len >= 8)
+        {
+            uint32_t lo = crc ^ (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24);
+            crc = tables.t[7][lo & 0xff] ^ tables.t[6][(lo >> 8) & 0xff] ^
+                  tables.t[5][(lo >> 16) & 0xff] ^ tables.t[4][lo >> 24] ^
+                  tables.t[3][p[4]] ^ tables.t[2][p[5]] ^ tables.t[1][p[6]] ^ tables.t[0][p[7]];
+            p += 8;
+            len -= 8;
+        }
+        while (len--)
+        {
+            crc = tables.t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+#if SINE_CRC_X86
+    bool cpuHasClmul()
+    {
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuid(regs, 1);
+        return (regs[2] & (1 << 1)) != 0 && (regs[2] & (1 << 19)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+        return (ecx & (1u << 1)) != 0 && (ecx & (1u << 19)) != 0;
+#endif
+    }
+
+    const bool hasClmul = cpuHasClmul();
+
+    // Folds 64-byte blocks with carry-less multiplies, then Barrett-reduces to 32 bits.
+    // len must be at least 64 and a multiple of 16.
+    SINE_TARGET_CLMUL
+    uint32_t crcClmul(uint32_t crc, const uint8_t* buf, size_t len)
+    {
+        alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+        alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+        alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+        alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+        __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+        x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00));
+        x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10));
+        x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20));
+        x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+
+        buf += 64;
+        len -= 64;
+
+        while (len >= 64)
+        {
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + 0x30)));
+
+            buf += 64;
+            len -= 64;
+        }
+
+        // Fold the four lanes into one.
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        while (len >= 16)
+        {
+            x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+            x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+            buf += 16;
+            len -= 16;
+        }
+
+        // 128 -> 64 bits.
+        x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+        x3 = _mm_setr_epi32(~0, 0, ~0, 0);
+        x1 = _mm_srli_si128(x1, 8);
+        x1 = _mm_xor_si128(x1, x2);
+
+        x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, x3);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        // Barrett reduction to 32 bits.
+        x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+        x2 = _mm_and_si128(x1, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+        x2 = _mm_and_si128(x2, x3);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+
+        return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+    }
+#endif
+
+#if SINE_CRC_ARM
+    uint32_t crcArm(uint32_t crc, const uint8_t* p, size_t len)
+    {
+        while (len >= 8)
+        {
+            uint64_t v;
+            __builtin_memcpy(&v, p, 8);
+            crc = __crc32d(crc, v);
+            p += 8;
+            len -= 8;
+        }
+        while (len--)
+        {
+            crc = __crc32b(crc, *p++);
+        }
+        return crc;
+    }
+#endif
+}
+
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+
+#if SINE_CRC_X86
+    if (hasClmul && len >= 64)
+    {
+        const size_t chunk = len & ~size_t(15);
+        crc = crcClmul(crc, p, chunk);
+        p += chunk;
+        len -= chunk;
+    }
+#elif SINE_CRC_ARM
+    return ~crcArm(crc, p, len);
+#endif
+
+    return ~crcScalar(crc, p, len);
+}
+
+const char* crc32Backend()
+{
+#if SINE_CRC_X86
+    return hasClmul ? "pclmul" : "slice-by-8";
+#elif SINE_CRC_ARM
+    return "armv8-crc";
+#else
+    return "slice-by-8";
+#endif
+}
+
+bool crc32File(const std::string& path, uint32_t& crc)
+{
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+
+    std::vector<uint8_t> chunk(1 << 18);
+    crc = 0;
+    size_t n;
+    while ((n = std::fread(chunk.data(), 1, chunk.size(), file)) > 0)
+    {
+        crc = crc32Update(crc, chunk.data(), n);
+    }
+
+    const bool ok = !std::ferror(file);
+    std::fclose(file);
+    return ok;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// CRC-32 as used by zip entries (reflected 0xEDB88320). Uses PCLMULQDQ folding on
+// x86 or the ARMv8 CRC32 instructions when available, slicing-by-8 otherwise.
+uint32_t crc32Update(uint32_t crc, const void* data, size_t len);
+
+const char* crc32Backend();
+
+// CRC-32 of a whole file; returns false when it cannot be read.
+bool crc32File(const std::string& path, uint32_t& crc);
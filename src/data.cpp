@@ -118,6 +118,22 @@ const std::vector<std::pair<std::string, std::vector<std::pair<std::string, std:
     }}
 };
 
+const std::string bootloaderReleases = "https://github.com/sineorg/bootloader/releases/download/v";
+const std::string sineReleases = "https://github.com/CosmoCreeper/Sine/releases/download/v";
+
 const std::string bootVersion = "0.1.1";
 const std::string sineVersion = "2.3c";
 const bool isCosine = true;
+
+// SHA-256 of the release archives for the versions above, checked while downloading.
+// Update together with bootVersion/sineVersion. An archive without an entry is
+// checked against the digest GitHub published for the release asset instead, and
+// not downloaded at all when there is none (see pinnedDigest()).
+const std::map<std::string, std::string> archiveDigests = {
+};
+
+const Release& compiledRelease()
+{
+    static const Release release = { bootVersion, sineVersion, archiveDigests };
+    return release;
+}
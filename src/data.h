@@ -20,6 +20,22 @@ extern const std::vector<
     >
 > browsers;
 
+extern const std::string bootloaderReleases;
+extern const std::string sineReleases;
 extern const std::string bootVersion;
 extern const std::string sineVersion;
-extern const bool isCosine;
\ No newline at end of file
+extern const bool isCosine;
+extern const std::map<std::string, std::string> archiveDigests;
+
+// A bootloader and Sine version to install, with the SHA-256 of their archives.
+struct Release
+{
+    std::string boot;
+    std::string sine;
+    // Downloads of an archive without a digest here (or a published one, see
+    // pinnedDigest()) fail.
+    std::map<std::string, std::string> digests;
+};
+
+// The versions and digests above; what everything but --agent installs.
+const Release& compiledRelease();
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <utility>
+
+// A value worked out on a thread of its own from the moment it is created, for
+// startup work the first frame does not need. get() blocks until it is done, the
+// first time only. Copies share the one result and may be read from different
+// threads; an exception thrown by the work is rethrown by get().
+template <typename T>
+class Deferred
+{
+public:
+    template <typename Work>
+    explicit Deferred(Work work) : result(std::async(std::launch::async, std::move(work)).share())
+    {
+    }
+
+    const T& get() const
+    {
+        return result.get();
+    }
+
+    // Blocks until the work is done, without rethrowing what it threw; for joining
+    // it before whatever it uses is torn down.
+    void wait() const
+    {
+        result.wait();
+    }
+
+    // Whether get() would return right away; for polling from the frame loop.
+    bool ready() const
+    {
+        return result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+private:
+    std::shared_future<T> result;
+};
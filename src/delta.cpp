@@ -0,0 +1,467 @@
+#include <delta.h>
+#include <platform.h>
+#include <sha256.h>
+#include <trace.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include <minizip-ng/mz.h>
+#include <minizip-ng/mz_zip.h>
+#include <minizip-ng/mz_zip_rw.h>
+
+namespace
+{
+    const char* manifestName = "sine-delta.txt";
+    const char* manifestHeader = "sine-delta 1";
+    const char diffMagic[] = "SDF1";
+
+    enum DiffOp : uint8_t
+    {
+        COPY = 1,
+        ADD = 2
+    };
+
+    // Matches are found on blocks of this size; shorter runs are sent as literals.
+    constexpr size_t blockSize = 32;
+    constexpr uint64_t hashBase = 1099511628211ull;
+
+    void putVarint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7)
+        {
+            const uint8_t byte = *p++;
+            value |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) return true;
+        }
+        return false;
+    }
+
+    uint64_t blockHash(const uint8_t* p)
+    {
+        uint64_t hash = 0;
+        for (size_t i = 0; i < blockSize; ++i)
+        {
+            hash = hash * hashBase + p[i];
+        }
+        return hash;
+    }
+
+    void putAdd(std::vector<uint8_t>& out, const uint8_t* data, size_t len)
+    {
+        if (len == 0) return;
+        out.push_back(ADD);
+        putVarint(out, len);
+        out.insert(out.end(), data, data + len);
+    }
+
+    std::string sha256Hex(const std::vector<uint8_t>& data)
+    {
+        Sha256 hash;
+        hash.update(data.data(), data.size());
+        return hash.finishHex();
+    }
+
+    std::vector<std::string> splitTabs(const std::string& line)
+    {
+        std::vector<std::string> fields;
+        size_t start = 0;
+        for (size_t tab = line.find('\t'); tab != std::string::npos; tab = line.find('\t', start))
+        {
+            fields.push_back(line.substr(start, tab - start));
+            start = tab + 1;
+        }
+        fields.push_back(line.substr(start));
+        return fields;
+    }
+
+    bool readFile(const std::filesystem::path& path, std::vector<uint8_t>& data)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return !file.bad();
+    }
+
+    bool writeFileReplacing(const std::filesystem::path& path, const std::vector<uint8_t>& data)
+    {
+        std::error_code ec;
+        if (std::filesystem::create_directories(path.parent_path(), ec))
+        {
+            fixFilePerms(path.parent_path().string());
+        }
+
+        std::filesystem::path temp = path;
+        temp += ".sine-tmp";
+        {
+            std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+            if (!file) return false;
+        }
+
+        std::filesystem::rename(temp, path, ec);
+        if (ec)
+        {
+            std::filesystem::remove(temp, ec);
+            return false;
+        }
+        fixFilePerms(path.string());
+        return true;
+    }
+
+    bool addZipEntry(void* writer, const std::string& name, const std::vector<uint8_t>& data)
+    {
+        mz_zip_file info = {};
+        info.filename = name.c_str();
+        info.compression_method = MZ_COMPRESS_METHOD_DEFLATE;
+        info.uncompressed_size = static_cast<int64_t>(data.size());
+        return mz_zip_writer_add_buffer(writer, const_cast<uint8_t*>(data.data()), static_cast<int32_t>(data.size()), &info) == MZ_OK;
+    }
+}
+
+std::vector<uint8_t> makeDiff(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target)
+{
+    std::vector<uint8_t> out(diffMagic, diffMagic + 4);
+    putVarint(out, target.size());
+
+    // Base blocks are indexed at block boundaries; the target is searched at every
+    // offset with a rolling hash, so shifted content still matches.
+    std::unordered_map<uint64_t, size_t> index;
+    for (size_t offset = 0; offset + blockSize <= base.size(); offset += blockSize)
+    {
+        index.emplace(blockHash(base.data() + offset), offset);
+    }
+
+    uint64_t topPower = 1;
+    for (size_t i = 1; i < blockSize; ++i)
+    {
+        topPower *= hashBase;
+    }
+
+    const uint8_t* t = target.data();
+    const size_t n = target.size();
+    size_t literal = 0;
+    size_t pos = 0;
+    uint64_t hash = n >= blockSize ? blockHash(t) : 0;
+
+    while (pos + blockSize <= n)
+    {
+        auto found = index.find(hash);
+        if (found != index.end() && memcmp(base.data() + found->second, t + pos, blockSize) == 0)
+        {
+            size_t from = found->second;
+            size_t len = blockSize;
+            while (from + len < base.size() && pos + len < n && base[from + len] == t[pos + len])
+            {
+                ++len;
+            }
+            // Grow backwards into the pending literal.
+            while (pos > literal && from > 0 && base[from - 1] == t[pos - 1])
+            {
+                --pos;
+                --from;
+                ++len;
+            }
+
+            putAdd(out, t + literal, pos - literal);
+            out.push_back(COPY);
+            putVarint(out, from);
+            putVarint(out, len);
+
+            pos += len;
+            literal = pos;
+            if (pos + blockSize <= n)
+            {
+                hash = blockHash(t + pos);
+            }
+            continue;
+        }
+
+        if (pos + blockSize < n)
+        {
+            hash = (hash - t[pos] * topPower) * hashBase + t[pos + blockSize];
+        }
+        ++pos;
+    }
+
+    putAdd(out, t + literal, n - literal);
+    return out;
+}
+
+bool applyDiff(const std::vector<uint8_t>& base, const uint8_t* diff, size_t diffSize, std::vector<uint8_t>& target)
+{
+    const uint8_t* p = diff;
+    const uint8_t* end = diff + diffSize;
+    if (diffSize < 4 || memcmp(p, diffMagic, 4) != 0) return false;
+    p += 4;
+
+    uint64_t size;
+    // Nothing a release archive holds comes close; a larger size is a corrupt diff.
+    if (!getVarint(p, end, size) || size > (uint64_t(1) << 30)) return false;
+    target.clear();
+    target.reserve(static_cast<size_t>(size));
+
+    while (p < end)
+    {
+        const uint8_t op = *p++;
+        if (op == COPY)
+        {
+            uint64_t from, len;
+            if (!getVarint(p, end, from) || !getVarint(p, end, len)) return false;
+            if (from > base.size() || len > base.size() - from || len > size - target.size()) return false;
+            target.insert(target.end(), base.begin() + from, base.begin() + from + len);
+        }
+        else if (op == ADD)
+        {
+            uint64_t len;
+            if (!getVarint(p, end, len)) return false;
+            if (len > static_cast<uint64_t>(end - p) || len > size - target.size()) return false;
+            target.insert(target.end(), p, p + len);
+            p += len;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return target.size() == size;
+}
+
+bool readZipFiles(const std::string& zipPath, std::map<std::string, std::vector<uint8_t>>& files)
+{
+    void* reader = mz_zip_reader_create();
+    if (mz_zip_reader_open_file(reader, zipPath.c_str()) != MZ_OK)
+    {
+        mz_zip_reader_delete(&reader);
+        return false;
+    }
+
+    int32_t err = mz_zip_reader_goto_first_entry(reader);
+    while (err == MZ_OK)
+    {
+        mz_zip_file* info = nullptr;
+        if (mz_zip_reader_entry_get_info(reader, &info) == MZ_OK &&
+            mz_zip_reader_entry_is_dir(reader) != MZ_OK)
+        {
+            const int32_t length = mz_zip_reader_entry_save_buffer_length(reader);
+            if (length < 0)
+            {
+                err = length;
+                break;
+            }
+
+            std::vector<uint8_t>& data = files[info->filename];
+            data.resize(static_cast<size_t>(length));
+            err = mz_zip_reader_entry_save_buffer(reader, data.data(), length);
+            if (err != MZ_OK) break;
+        }
+        err = mz_zip_reader_goto_next_entry(reader);
+    }
+
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+    return err == MZ_END_OF_LIST;
+}
+
+bool makeDelta(const std::string& oldZip, const std::string& newZip,
+    const std::string& fromVersion, const std::string& toVersion, const std::string& outPath)
+{
+    std::map<std::string, std::vector<uint8_t>> oldFiles, newFiles;
+    if (!readZipFiles(oldZip, oldFiles))
+    {
+        std::cerr << "Could not read " << oldZip << ".\n";
+        return false;
+    }
+    if (!readZipFiles(newZip, newFiles))
+    {
+        std::cerr << "Could not read " << newZip << ".\n";
+        return false;
+    }
+
+    std::ostringstream manifest;
+    manifest << manifestHeader << "\n";
+    manifest << "from\t" << fromVersion << "\n";
+    manifest << "to\t" << toVersion << "\n";
+
+    std::vector<std::pair<std::string, std::vector<uint8_t>>> entries;
+    for (const auto& [path, data] : oldFiles)
+    {
+        if (newFiles.count(path) == 0)
+        {
+            manifest << "remove\t" << path << "\n";
+        }
+    }
+
+    for (const auto& [path, data] : newFiles)
+    {
+        auto old = oldFiles.find(path);
+        if (old != oldFiles.end() && old->second == data) continue;
+
+        if (old != oldFiles.end())
+        {
+            std::vector<uint8_t> diff = makeDiff(old->second, data);
+            // A rewrite diffs worse than it ships whole.
+            if (diff.size() < data.size())
+            {
+                manifest << "patch\t" << path << "\t" << sha256Hex(old->second) << "\t" << sha256Hex(data) << "\n";
+                entries.emplace_back("patches/" + path, std::move(diff));
+                continue;
+            }
+        }
+
+        manifest << "add\t" << path << "\t" << sha256Hex(data) << "\n";
+        entries.emplace_back("files/" + path, data);
+    }
+
+    void* writer = mz_zip_writer_create();
+    mz_zip_writer_set_compress_method(writer, MZ_COMPRESS_METHOD_DEFLATE);
+    mz_zip_writer_set_compress_level(writer, MZ_COMPRESS_LEVEL_BEST);
+    if (mz_zip_writer_open_file(writer, outPath.c_str(), 0, 0) != MZ_OK)
+    {
+        mz_zip_writer_delete(&writer);
+        std::cerr << "Could not create " << outPath << ".\n";
+        return false;
+    }
+
+    const std::string text = manifest.str();
+    bool ok = addZipEntry(writer, manifestName, std::vector<uint8_t>(text.begin(), text.end()));
+    for (const auto& [name, data] : entries)
+    {
+        ok = ok && addZipEntry(writer, name, data);
+    }
+
+    ok = mz_zip_writer_close(writer) == MZ_OK && ok;
+    mz_zip_writer_delete(&writer);
+    if (!ok)
+    {
+        std::cerr << "Could not write " << outPath << ".\n";
+    }
+    return ok;
+}
+
+bool applyDelta(const std::string& deltaPath, const std::string& targetDir,
+    const std::string& fromVersion, const std::string& toVersion, std::string& error,
+    const EntryFilter& filter)
+{
+    TraceSpan span("delta", "extract", deltaPath);
+
+    std::map<std::string, std::vector<uint8_t>> package;
+    auto manifest = package.end();
+    if (!readZipFiles(deltaPath, package) || (manifest = package.find(manifestName)) == package.end())
+    {
+        error = "Could not read the delta package.";
+        return false;
+    }
+
+    std::istringstream in(std::string(manifest->second.begin(), manifest->second.end()));
+    std::string line;
+    if (!std::getline(in, line) || line != manifestHeader)
+    {
+        error = "Unknown delta package format.";
+        return false;
+    }
+
+    const std::filesystem::path root(targetDir);
+    std::vector<std::pair<std::filesystem::path, std::vector<uint8_t>>> writes;
+    std::vector<std::filesystem::path> removes;
+    std::string from, to;
+
+    while (std::getline(in, line))
+    {
+        if (line.empty()) continue;
+
+        const std::vector<std::string> fields = splitTabs(line);
+        const std::string& kind = fields[0];
+        // Manifest paths come from the network; anything that could leave the target folder is refused.
+        if (fields.size() >= 2 && kind != "from" && kind != "to" && !safeRelative(fields[1]))
+        {
+            error = "Refusing delta path " + fields[1] + ".";
+            return false;
+        }
+
+        if (kind == "from" && fields.size() == 2)
+        {
+            from = fields[1];
+        }
+        else if (kind == "to" && fields.size() == 2)
+        {
+            to = fields[1];
+        }
+        else if ((kind == "remove" && fields.size() == 2)
+            || (filter && (kind == "add" || kind == "patch") && !filter(fields[1])))
+        {
+            removes.push_back(root / fields[1]);
+        }
+        else if (kind == "add" && fields.size() == 3)
+        {
+            auto file = package.find("files/" + fields[1]);
+            if (file == package.end() || sha256Hex(file->second) != fields[2])
+            {
+                error = "Delta file " + fields[1] + " does not match its hash.";
+                return false;
+            }
+            writes.emplace_back(root / fields[1], std::move(file->second));
+        }
+        else if (kind == "patch" && fields.size() == 4)
+        {
+            auto diff = package.find("patches/" + fields[1]);
+            std::vector<uint8_t> base, result;
+            if (diff == package.end() || !readFile(root / fields[1], base) || sha256Hex(base) != fields[2])
+            {
+                error = "Installed " + fields[1] + " is not the delta's base.";
+                return false;
+            }
+            if (!applyDiff(base, diff->second.data(), diff->second.size(), result) || sha256Hex(result) != fields[3])
+            {
+                error = "Patched " + fields[1] + " does not match its hash.";
+                return false;
+            }
+            writes.emplace_back(root / fields[1], std::move(result));
+        }
+        else
+        {
+            error = "Invalid delta manifest line: " + line;
+            return false;
+        }
+    }
+
+    if (from != fromVersion || to != toVersion)
+    {
+        error = "Delta package is for " + from + " to " + to + ".";
+        return false;
+    }
+
+    // Everything verified; only now is the installed tree touched.
+    for (const auto& [path, data] : writes)
+    {
+        if (!writeFileReplacing(path, data))
+        {
+            error = "Could not write " + path.string() + ".";
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    for (const std::filesystem::path& path : removes)
+    {
+        std::filesystem::remove(path, ec);
+    }
+
+    return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <extract.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Delta packages move the files one release archive installed to the next release
+// without downloading the whole archive again. A package is a zip holding
+//
+//   sine-delta.txt    the manifest
+//   files/<path>      files the new release added, or changed beyond patching
+//   patches/<path>    binary diffs of changed files against the base release
+//
+// The manifest starts with "sine-delta 1", followed by one record per line with
+// fields separated by tabs:
+//
+//   from    <version>
+//   to      <version>
+//   remove  <path>
+//   add     <path>  <sha256>
+//   patch   <path>  <base sha256>  <result sha256>
+//
+// Paths are relative to the folder the archive extracts into.
+
+// Binary diffs are a list of copy (offset and length into the base) and add
+// (literal bytes) instructions after the "SDF1" magic and the result size, all
+// numbers as LEB128 varints.
+std::vector<uint8_t> makeDiff(const std::vector<uint8_t>& base, const std::vector<uint8_t>& target);
+bool applyDiff(const std::vector<uint8_t>& base, const uint8_t* diff, size_t diffSize, std::vector<uint8_t>& target);
+
+// Reads every file entry of a zip into memory, keyed by its name.
+bool readZipFiles(const std::string& zipPath, std::map<std::string, std::vector<uint8_t>>& files);
+
+// Generator side: the package that turns what oldZip installed into what newZip installs.
+bool makeDelta(const std::string& oldZip, const std::string& newZip,
+    const std::string& fromVersion, const std::string& toVersion, const std::string& outPath);
+
+// Applies a package to targetDir. Every base and result hash is checked before the
+// first file is written, so a package that does not fit leaves targetDir as it was.
+// Returns false with error set; callers fall back to the full archive. Files the
+// filter rejects are not patched or added but removed, like a filtered extract
+// would have left them.
+bool applyDelta(const std::string& deltaPath, const std::string& targetDir,
+    const std::string& fromVersion, const std::string& toVersion, std::string& error,
+    const EntryFilter& filter = nullptr);
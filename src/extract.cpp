@@ -0,0 +1,506 @@
+#include <crc32.h>
+#include <extract.h>
+#include <inflate.h>
+#include <platform.h>
+#include <progress.h>
+#include <throttle.h>
+#include <trace.h>
+#include <uring.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <minizip-ng/mz.h>
+#include <minizip-ng/mz_zip.h>
+#include <minizip-ng/mz_zip_rw.h>
+
+bool safeRelative(const std::string& path)
+{
+    const std::filesystem::path relative(path);
+    if (path.empty() || relative.is_absolute() || relative.has_root_name()) return false;
+    for (const auto& part : relative)
+    {
+        if (part == "..") return false;
+    }
+    return true;
+}
+
+namespace
+{
+    // Below this size preallocating and mapping cost more syscalls than they save;
+    // such files are inflated into memory and written with one call.
+    constexpr int64_t mapThreshold = 256 << 10;
+    // Unmapped outputs are written in chunks of this size.
+    constexpr size_t writeChunk = 1 << 20;
+
+    // Inflates the open entry into dst until size bytes arrived or the entry ended.
+    // Returns the byte count, or a negative MZ_* error.
+    int64_t inflateInto(void* reader, uint8_t* dst, int64_t size)
+    {
+        int64_t total = 0;
+        while (total < size)
+        {
+            const int32_t want = static_cast<int32_t>(std::min<int64_t>(size - total, INT32_MAX));
+            const int32_t got = mz_zip_reader_entry_read(reader, dst + total, want);
+            if (got < 0) return got;
+            if (got == 0) break;
+            total += got;
+            // Everything inflated ends up on disk, whichever way it is written.
+            throttleWrite(static_cast<uint64_t>(got));
+        }
+        return total;
+    }
+
+    // Hands out the bytes of the current entry. An entry read whole in one call goes
+    // through the inflate backend when there is one: its compressed bytes are read
+    // raw and inflated at once, then checked against the CRC minizip would check.
+    // Anything else streams through minizip-ng.
+    class EntryReader
+    {
+    public:
+        EntryReader(void* reader, const mz_zip_file* info) : reader(reader), info(info)
+        {
+        }
+
+        ~EntryReader()
+        {
+            if (streaming) mz_zip_reader_entry_close(reader);
+        }
+
+        // Same contract as inflateInto.
+        int64_t read(uint8_t* dst, int64_t size)
+        {
+            if (!streaming && size >= info->uncompressed_size && wholeEntry())
+            {
+                return inflateWhole(dst);
+            }
+            if (!streaming)
+            {
+                const int32_t err = mz_zip_reader_entry_open(reader);
+                if (err != MZ_OK) return err;
+                streaming = true;
+            }
+            return inflateInto(reader, dst, size);
+        }
+
+    private:
+        bool wholeEntry() const
+        {
+            return inflateAvailable()
+                && info->compression_method == MZ_COMPRESS_METHOD_DEFLATE
+                && !(info->flag & MZ_ZIP_FLAG_ENCRYPTED)
+                && info->compressed_size > 0 && info->compressed_size <= INT32_MAX
+                && info->uncompressed_size > 0;
+        }
+
+        int64_t inflateWhole(uint8_t* dst)
+        {
+            void* zip = nullptr;
+            mz_zip_reader_get_zip_handle(reader, &zip);
+            int32_t err = mz_zip_entry_read_open(zip, 1, nullptr);
+            if (err != MZ_OK) return err;
+
+            std::vector<uint8_t> compressed(static_cast<size_t>(info->compressed_size));
+            int64_t total = 0;
+            while (total < info->compressed_size)
+            {
+                const int32_t got = mz_zip_entry_read(zip, compressed.data() + total,
+                    static_cast<int32_t>(info->compressed_size - total));
+                if (got <= 0)
+                {
+                    err = got < 0 ? got : MZ_DATA_ERROR;
+                    break;
+                }
+                total += got;
+            }
+            mz_zip_entry_close(zip);
+            if (err != MZ_OK) return err;
+
+            const size_t size = static_cast<size_t>(info->uncompressed_size);
+            if (!inflateRaw(compressed.data(), compressed.size(), dst, size)) return MZ_DATA_ERROR;
+            if (crc32Update(0, dst, size) != info->crc) return MZ_CRC_ERROR;
+
+            throttleWrite(size);
+            return info->uncompressed_size;
+        }
+
+        void* reader;
+        const mz_zip_file* info;
+        bool streaming = false;
+    };
+
+    struct OutputResult
+    {
+        int64_t bytes = 0;
+        // MZ_* error when source is "minizip", errno or GetLastError() when "os".
+        int32_t code = 0;
+        const char* source = nullptr;
+    };
+
+#ifdef _WIN32
+    OutputResult inflateToFile(void* reader, const mz_zip_file* info, const std::string& outPath)
+    {
+        const int64_t size = info->uncompressed_size;
+        EntryReader entry(reader, info);
+        OutputResult result;
+        HANDLE file = CreateFileA(outPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+            CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            result.code = static_cast<int32_t>(GetLastError());
+            result.source = "os";
+            return result;
+        }
+
+        // Setting the end of file reserves the clusters up front, so a full disk fails
+        // here instead of leaving a truncated file.
+        const bool large = size >= mapThreshold;
+        LARGE_INTEGER end;
+        end.QuadPart = size;
+        if (large && (!SetFilePointerEx(file, end, NULL, FILE_BEGIN) || !SetEndOfFile(file)))
+        {
+            result.code = static_cast<int32_t>(GetLastError());
+            result.source = "os";
+            CloseHandle(file);
+            return result;
+        }
+
+        HANDLE mapping = large ? CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, 0, NULL) : NULL;
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, 0) : nullptr;
+        if (view)
+        {
+            result.bytes = entry.read(static_cast<uint8_t*>(view), size);
+            UnmapViewOfFile(view);
+        }
+        else if (size > 0)
+        {
+            std::vector<uint8_t> buffer(static_cast<size_t>(std::min<int64_t>(size, writeChunk)));
+            LARGE_INTEGER start = {};
+            SetFilePointerEx(file, start, NULL, FILE_BEGIN);
+            while (result.bytes < size)
+            {
+                const int64_t got = entry.read(buffer.data(), std::min<int64_t>(size - result.bytes, buffer.size()));
+                if (got <= 0)
+                {
+                    if (got < 0) result.bytes = got;
+                    break;
+                }
+                DWORD written = 0;
+                if (!WriteFile(file, buffer.data(), static_cast<DWORD>(got), &written, NULL) || written != static_cast<DWORD>(got))
+                {
+                    result.code = static_cast<int32_t>(GetLastError());
+                    result.source = "os";
+                    break;
+                }
+                result.bytes += got;
+            }
+        }
+        if (mapping) CloseHandle(mapping);
+
+        if (result.bytes < 0)
+        {
+            result.code = static_cast<int32_t>(result.bytes);
+            result.source = "minizip";
+        }
+        else if (result.bytes < size)
+        {
+            // The archive promised more than it held; keep what arrived.
+            end.QuadPart = result.bytes;
+            SetFilePointerEx(file, end, NULL, FILE_BEGIN);
+            SetEndOfFile(file);
+        }
+
+        CloseHandle(file);
+        return result;
+    }
+#else
+    OutputResult inflateToFile(void* reader, const mz_zip_file* info, const std::string& outPath)
+    {
+        const int64_t size = info->uncompressed_size;
+        EntryReader entry(reader, info);
+        OutputResult result;
+        int fd = open(outPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            result.code = errno;
+            result.source = "os";
+            return result;
+        }
+
+        // Reserving the blocks up front keeps the file contiguous and turns a full disk
+        // into an error here instead of a truncated file. Only reserved blocks are safe
+        // to write through a mapping: a store into a hole on a full disk is a SIGBUS.
+        bool reserved = false;
+        if (size >= mapThreshold)
+        {
+            const int err = posix_fallocate(fd, 0, static_cast<off_t>(size));
+            if (err == ENOSPC || err == EFBIG)
+            {
+                result.code = err;
+                result.source = "os";
+                close(fd);
+                return result;
+            }
+            reserved = err == 0;
+        }
+
+        void* view = reserved
+            ? mmap(nullptr, static_cast<size_t>(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+            : MAP_FAILED;
+        if (view != MAP_FAILED)
+        {
+            result.bytes = entry.read(static_cast<uint8_t*>(view), size);
+            munmap(view, static_cast<size_t>(size));
+        }
+        else if (size > 0)
+        {
+            std::vector<uint8_t> buffer(static_cast<size_t>(std::min<int64_t>(size, writeChunk)));
+            while (result.bytes < size)
+            {
+                const int64_t got = entry.read(buffer.data(), std::min<int64_t>(size - result.bytes, buffer.size()));
+                if (got <= 0)
+                {
+                    if (got < 0) result.bytes = got;
+                    break;
+                }
+                if (pwrite(fd, buffer.data(), static_cast<size_t>(got), static_cast<off_t>(result.bytes)) != got)
+                {
+                    result.code = errno;
+                    result.source = "os";
+                    break;
+                }
+                result.bytes += got;
+            }
+        }
+
+        if (result.bytes < 0)
+        {
+            result.code = static_cast<int32_t>(result.bytes);
+            result.source = "minizip";
+        }
+        else if (result.bytes < size)
+        {
+            // The archive promised more than it held; keep what arrived.
+            if (ftruncate(fd, static_cast<off_t>(result.bytes)) != 0 && !result.source)
+            {
+                result.code = errno;
+                result.source = "os";
+            }
+        }
+
+        if (close(fd) != 0 && !result.source)
+        {
+            result.code = errno;
+            result.source = "os";
+        }
+        return result;
+    }
+#endif
+
+    void reportFailure(const std::string& archive, const std::string& name, const OutputResult& result)
+    {
+        const std::string reason = strcmp(result.source, "os") == 0
+            ? std::system_category().message(result.code)
+            : "failed to read";
+        std::cerr << "Failed to extract " << name << ": " << reason << ".\n";
+        progressError(result.source, result.code, archive + ": " + name + ": " + reason);
+    }
+
+#ifndef _WIN32
+    OutputResult writeBuffer(const std::string& outPath, const std::vector<uint8_t>& data)
+    {
+        OutputResult result;
+        int fd = open(outPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0 || pwrite(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size()))
+        {
+            result.code = errno;
+            result.source = "os";
+        }
+        if (fd >= 0) close(fd);
+        result.bytes = static_cast<int64_t>(data.size());
+        return result;
+    }
+#endif
+
+    // Writes what the ring has queued; whatever it could not write is retried directly.
+    // The ring only exists on Linux, so elsewhere nothing is ever queued.
+    bool flushWriter(UringWriter& writer, const std::string& archive, const std::string& outputDir)
+    {
+        bool ok = true;
+#ifndef _WIN32
+        for (const UringWriter::File& file : writer.flush())
+        {
+            const OutputResult written = writeBuffer(file.path, file.data);
+            if (written.source)
+            {
+                reportFailure(archive, file.path.substr(outputDir.size() + 1), written);
+                ok = false;
+                continue;
+            }
+            fixFilePerms(file.path);
+        }
+#endif
+        return ok;
+    }
+
+    bool extractEntries(void* reader, const std::string& archive, const std::string& outputDir, const EntryFilter& filter)
+    {
+        std::filesystem::create_directories(outputDir);
+        fixFilePerms(outputDir);
+
+        if (mz_zip_reader_goto_first_entry(reader) != MZ_OK)
+        {
+            return false;
+        }
+
+        // Small files go out in batches through io_uring where the kernel has it.
+        UringWriter writer;
+
+        bool ok = true;
+        uint64_t entries = 0;
+        uint64_t bytes = 0;
+        do
+        {
+            mz_zip_file* file_info = nullptr;
+            int32_t err = mz_zip_reader_entry_get_info(reader, &file_info);
+            if (err != MZ_OK)
+            {
+                progressError("minizip", err, archive + ": cannot read entry info");
+                ok = false;
+                break;
+            }
+
+            if (filter && !filter(file_info->filename))
+            {
+                continue;
+            }
+
+            // Archives come from mirrors too; an entry must not land outside outputDir.
+            if (!safeRelative(file_info->filename))
+            {
+                std::cerr << "Refusing entry " << file_info->filename << " in " << archive << ".\n";
+                progressError("install", 0, archive + ": refusing entry " + file_info->filename);
+                ok = false;
+                break;
+            }
+
+            TraceSpan span("entry", "extract", file_info->filename);
+            std::string outPath = outputDir + "/" + file_info->filename;
+
+            if (mz_zip_reader_entry_is_dir(reader) == MZ_OK)
+            {
+                std::filesystem::create_directories(outPath);
+                fixFilePerms(outPath);
+            }
+            else
+            {
+                std::filesystem::create_directories(
+                    std::filesystem::path(outPath).parent_path());
+
+                fixFilePerms(std::filesystem::path(outPath).parent_path().string());
+
+                if (writer.available() && file_info->uncompressed_size < mapThreshold)
+                {
+                    std::vector<uint8_t> data(static_cast<size_t>(file_info->uncompressed_size));
+                    const int64_t got = EntryReader(reader, file_info).read(data.data(), file_info->uncompressed_size);
+
+                    if (got < 0)
+                    {
+                        OutputResult failed;
+                        failed.code = static_cast<int32_t>(got);
+                        failed.source = "minizip";
+                        reportFailure(archive, file_info->filename, failed);
+                        ok = false;
+                        continue;
+                    }
+
+                    data.resize(static_cast<size_t>(got));
+                    bytes += static_cast<uint64_t>(got);
+                    writer.add(outPath, std::move(data));
+                    if (writer.full())
+                    {
+                        ok = flushWriter(writer, archive, outputDir) && ok;
+                    }
+                    ++entries;
+                    continue;
+                }
+
+                const OutputResult written = inflateToFile(reader, file_info, outPath);
+
+                if (written.source)
+                {
+                    reportFailure(archive, file_info->filename, written);
+                    ok = false;
+                    continue;
+                }
+
+                fixFilePerms(outPath);
+                bytes += static_cast<uint64_t>(written.bytes);
+            }
+            ++entries;
+        } while (mz_zip_reader_goto_next_entry(reader) == MZ_OK);
+
+        ok = flushWriter(writer, archive, outputDir) && ok;
+
+        progressExtract(archive, entries, bytes);
+        return ok;
+    }
+}
+
+bool extractZip(const std::string& zipPath, const std::string& outputDir, const EntryFilter& filter)
+{
+    void* reader = mz_zip_reader_create();
+    int32_t err = mz_zip_reader_open_file(reader, zipPath.c_str());
+    if (err != MZ_OK)
+    {
+        std::cerr << "Failed to open " << zipPath << ".\n";
+        progressError("minizip", err, "Failed to open " + zipPath);
+        mz_zip_reader_delete(&reader);
+        return false;
+    }
+
+    bool ok = extractEntries(reader, std::filesystem::path(zipPath).filename().string(), outputDir, filter);
+
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+    return ok;
+}
+
+bool extractZipBuffer(const void* data, size_t size, const std::string& outputDir, const std::string& name,
+    const EntryFilter& filter)
+{
+    void* reader = mz_zip_reader_create();
+
+    // The buffer is only read, so minizip can use it in place without a copy.
+    int32_t err = mz_zip_reader_open_buffer(reader, static_cast<uint8_t*>(const_cast<void*>(data)),
+        static_cast<int32_t>(size), 0);
+    if (err != MZ_OK)
+    {
+        std::cerr << "Failed to open embedded " << name << ".\n";
+        progressError("minizip", err, "Failed to open embedded " + name);
+        mz_zip_reader_delete(&reader);
+        return false;
+    }
+
+    bool ok = extractEntries(reader, name, outputDir, filter);
+
+    mz_zip_reader_close(reader);
+    mz_zip_reader_delete(&reader);
+    return ok;
+}
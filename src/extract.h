@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Decides per entry name (as stored in the archive) whether it is extracted.
+// Rejected entries are skipped from the central directory without being inflated.
+using EntryFilter = std::function<bool(const std::string& name)>;
+
+// Whether a path from an archive or manifest stays below the folder it is
+// resolved against: relative, without a root name and without "..".
+bool safeRelative(const std::string& path);
+
+// Extracts the entries of a zip archive below outputDir, all of them unless a
+// filter is given. Returns false when the archive cannot be opened, an entry
+// fails to extract or an entry name is not safeRelative(), which stops the
+// extraction at that entry.
+bool extractZip(const std::string& zipPath, const std::string& outputDir, const EntryFilter& filter = nullptr);
+
+// Same, reading the archive from memory (e.g. the payload appended to the executable).
+// name only labels progress events.
+bool extractZipBuffer(const void* data, size_t size, const std::string& outputDir, const std::string& name = "embedded",
+    const EntryFilter& filter = nullptr);
@@ -0,0 +1,283 @@
+#include <frames.h>
+
+#include <glad/gl.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Frames kept for the overlay, about four seconds at 60 Hz.
+    constexpr int recentFrames = 240;
+    // Queries in flight; results are read this many frames late at the latest.
+    constexpr int queryCount = 4;
+    // Top of the overlay's histogram; longer frames are clipped.
+    constexpr float histogramMs = 50.0f;
+
+    struct Section
+    {
+        const char* name;
+        float lastMs;
+        std::vector<float> samples;
+    };
+
+    struct Profile
+    {
+        bool enabled = false;
+        bool visible = false;
+
+        Clock::time_point frameStart;
+        Clock::time_point lastFrameEnd;
+        bool framed = false;
+
+        // The whole session, for the report.
+        std::vector<float> frameMs;
+        std::vector<float> cpuMs;
+        std::vector<float> gpuMs;
+        std::vector<Section> sections;
+
+        float recent[recentFrames] = {};
+        int recentNext = 0;
+        int recentCount = 0;
+
+        float lastCpuMs = 0.0f;
+        float lastGpuMs = -1.0f;
+        int vertices = 0;
+        int indices = 0;
+        int commands = 0;
+        int lists = 0;
+
+        bool queriesMade = false;
+        bool timerQueries = false;
+        GLuint queries[queryCount] = {};
+        bool pending[queryCount] = {};
+        int querySlot = 0;
+        bool queryOpen = false;
+    };
+
+    Profile profile;
+
+    float millisecondsSince(Clock::time_point start, Clock::time_point end)
+    {
+        return std::chrono::duration<float, std::milli>(end - start).count();
+    }
+
+    float percentile(std::vector<float> values, double p)
+    {
+        if (values.empty()) return 0.0f;
+        const size_t rank = std::min(values.size() - 1, static_cast<size_t>(p * values.size()));
+        std::nth_element(values.begin(), values.begin() + rank, values.end());
+        return values[rank];
+    }
+
+    // Reads a finished query without waiting on one that is not.
+    void collectQuery(int slot)
+    {
+        GLint available = 0;
+        glGetQueryObjectiv(profile.queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return;
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(profile.queries[slot], GL_QUERY_RESULT, &nanoseconds);
+        profile.pending[slot] = false;
+        profile.lastGpuMs = static_cast<float>(nanoseconds / 1e6);
+        profile.gpuMs.push_back(profile.lastGpuMs);
+    }
+
+    void reportLine(const char* name, const std::vector<float>& samples)
+    {
+        char line[160];
+        std::snprintf(line, sizeof(line), "  %-8s p50 %7.2f  p90 %7.2f  p99 %7.2f  max %7.2f  (%zu)",
+            name, percentile(samples, 0.5), percentile(samples, 0.9), percentile(samples, 0.99),
+            samples.empty() ? 0.0f : *std::max_element(samples.begin(), samples.end()), samples.size());
+        std::cerr << line << "\n";
+    }
+}
+
+void frameProfileEnable()
+{
+    profile.enabled = true;
+    profile.visible = true;
+}
+
+bool frameProfileEnabled()
+{
+    return profile.enabled;
+}
+
+void frameProfileToggle()
+{
+    if (!profile.enabled)
+    {
+        frameProfileEnable();
+        return;
+    }
+    profile.visible = !profile.visible;
+}
+
+void frameProfileBeginFrame()
+{
+    if (!profile.enabled) return;
+    profile.frameStart = Clock::now();
+}
+
+void frameProfileSection(const char* name, double ms)
+{
+    if (!profile.enabled) return;
+
+    auto section = std::find_if(profile.sections.begin(), profile.sections.end(),
+        [&](const Section& s) { return s.name == name; });
+    if (section == profile.sections.end())
+    {
+        profile.sections.push_back({ name, 0.0f, {} });
+        section = profile.sections.end() - 1;
+    }
+    section->lastMs = static_cast<float>(ms);
+    section->samples.push_back(section->lastMs);
+}
+
+void frameProfileGpuBegin()
+{
+    if (!profile.enabled) return;
+
+    if (!profile.queriesMade)
+    {
+        // GL_TIME_ELAPSED is core in 3.3; the wizard only asks for a 3.2 context.
+        profile.queriesMade = true;
+        profile.timerQueries = GLAD_GL_VERSION_3_3 != 0;
+        if (profile.timerQueries)
+        {
+            glGenQueries(queryCount, profile.queries);
+        }
+    }
+    if (!profile.timerQueries) return;
+
+    // The oldest query still unread means the GPU is that far behind; skip this frame rather than wait.
+    const int slot = profile.querySlot;
+    if (profile.pending[slot]) collectQuery(slot);
+    if (profile.pending[slot]) return;
+
+    glBeginQuery(GL_TIME_ELAPSED, profile.queries[slot]);
+    profile.queryOpen = true;
+}
+
+void frameProfileGpuEnd()
+{
+    if (!profile.queryOpen) return;
+
+    glEndQuery(GL_TIME_ELAPSED);
+    profile.pending[profile.querySlot] = true;
+    profile.querySlot = (profile.querySlot + 1) % queryCount;
+    profile.queryOpen = false;
+}
+
+void frameProfileEndFrame(const ImDrawData* drawData)
+{
+    if (!profile.enabled) return;
+
+    const Clock::time_point now = Clock::now();
+    profile.lastCpuMs = millisecondsSince(profile.frameStart, now);
+    profile.cpuMs.push_back(profile.lastCpuMs);
+    if (profile.framed)
+    {
+        const float ms = millisecondsSince(profile.lastFrameEnd, now);
+        profile.frameMs.push_back(ms);
+        profile.recent[profile.recentNext] = ms;
+        profile.recentNext = (profile.recentNext + 1) % recentFrames;
+        profile.recentCount = std::min(profile.recentCount + 1, recentFrames);
+    }
+    profile.lastFrameEnd = now;
+    profile.framed = true;
+
+    // Oldest first, so gpuMs stays in frame order.
+    for (int i = 0; i < queryCount; ++i)
+    {
+        const int slot = (profile.querySlot + i) % queryCount;
+        if (profile.pending[slot]) collectQuery(slot);
+    }
+
+    if (drawData)
+    {
+        profile.vertices = drawData->TotalVtxCount;
+        profile.indices = drawData->TotalIdxCount;
+        profile.lists = drawData->CmdListsCount;
+        profile.commands = 0;
+        for (int i = 0; i < drawData->CmdListsCount; ++i)
+        {
+            profile.commands += drawData->CmdLists[i]->CmdBuffer.Size;
+        }
+    }
+}
+
+void frameProfileDraw()
+{
+    if (!profile.enabled || !profile.visible) return;
+
+    const std::vector<float> recent(profile.recent, profile.recent + profile.recentCount);
+    const float lastMs = profile.recent[(profile.recentNext + recentFrames - 1) % recentFrames];
+
+    ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 10.0f, 10.0f), ImGuiCond_Always, ImVec2(1.0f, 0.0f));
+    ImGui::SetNextWindowBgAlpha(0.85f);
+    ImGui::Begin("Frame profile", nullptr,
+        ImGuiWindowFlags_NoDecoration |
+        ImGuiWindowFlags_AlwaysAutoResize |
+        ImGuiWindowFlags_NoSavedSettings |
+        ImGuiWindowFlags_NoFocusOnAppearing |
+        ImGuiWindowFlags_NoNav |
+        ImGuiWindowFlags_NoInputs);
+
+    ImGui::Text("frame %.2f ms  p50 %.2f  p99 %.2f", lastMs, percentile(recent, 0.5), percentile(recent, 0.99));
+    const float fontSize = ImGui::GetFontSize();
+    ImGui::PlotHistogram("##frames", profile.recent, profile.recentCount, profile.recentCount < recentFrames ? 0 : profile.recentNext,
+        nullptr, 0.0f, histogramMs, ImVec2(fontSize * 16.0f, fontSize * 3.0f));
+
+    if (profile.timerQueries)
+    {
+        ImGui::Text("cpu %.2f ms  gpu %.2f ms", profile.lastCpuMs, profile.lastGpuMs);
+    }
+    else
+    {
+        ImGui::Text("cpu %.2f ms  gpu n/a", profile.lastCpuMs);
+    }
+    ImGui::Text("%d vertices, %d indices", profile.vertices, profile.indices);
+    ImGui::Text("%d commands in %d draw lists", profile.commands, profile.lists);
+
+    ImGui::Separator();
+    for (const Section& section : profile.sections)
+    {
+        ImGui::Text("%-6s %6.2f ms  max %6.2f", section.name, section.lastMs,
+            *std::max_element(section.samples.begin(), section.samples.end()));
+    }
+
+    ImGui::End();
+}
+
+void frameProfileShutdown()
+{
+    if (!profile.enabled) return;
+
+    std::cerr << "Frame profile, milliseconds:\n";
+    reportLine("frame", profile.frameMs);
+    reportLine("cpu", profile.cpuMs);
+    if (profile.timerQueries)
+    {
+        reportLine("gpu", profile.gpuMs);
+    }
+    for (const Section& section : profile.sections)
+    {
+        reportLine(section.name, section.samples);
+    }
+
+    if (profile.timerQueries)
+    {
+        glDeleteQueries(queryCount, profile.queries);
+        profile.timerQueries = false;
+    }
+    profile.enabled = false;
+}
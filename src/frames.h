@@ -0,0 +1,36 @@
+#pragma once
+
+struct ImDrawData;
+
+// Frame-time profiler for the wizard (--profile-ui, or F12 to toggle its overlay
+// at any time). Once enabled it records, for every frame:
+//
+//   - the time between frames and the CPU time spent building one,
+//   - the CPU time of each wizard page (frameProfileSection),
+//   - the GPU time of drawing it, from GL_TIME_ELAPSED queries read back a few
+//     frames later so they never stall the pipeline (GL 3.3 or later only),
+//   - the vertices, indices, draw commands and draw lists ImGui submitted.
+//
+// The overlay shows the recent frames; frameProfileShutdown() writes percentiles
+// over the whole session to stderr. Everything here runs on the UI thread, and
+// every call but frameProfileToggle() is a branch while profiling is off.
+
+void frameProfileEnable();
+bool frameProfileEnabled();
+// Shows or hides the overlay, enabling the profiler the first time.
+void frameProfileToggle();
+
+void frameProfileBeginFrame();
+// CPU time of one part of the frame; name must be a string literal.
+void frameProfileSection(const char* name, double ms);
+// Around the draw calls of the frame.
+void frameProfileGpuBegin();
+void frameProfileGpuEnd();
+// After the frame is drawn, before it is presented.
+void frameProfileEndFrame(const ImDrawData* drawData);
+
+// Between ImGui::NewFrame() and ImGui::Render().
+void frameProfileDraw();
+
+// Writes the report, then releases the GL queries; the context must still be current.
+void frameProfileShutdown();
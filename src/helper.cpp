@@ -0,0 +1,395 @@
+#include <helper.h>
+#include <platform.h>
+#include <sha256.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <shellapi.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const char* manifestHeader = "sine-helper 2";
+
+    const char* kindName(HelperOp::Kind kind)
+    {
+        switch (kind)
+        {
+        case HelperOp::Kind::MKDIR: return "mkdir";
+        case HelperOp::Kind::COPY: return "copy";
+        default: return "remove";
+        }
+    }
+
+    // One operation per line, fields separated by tabs; copies end with the source's digest.
+    std::string writeManifest(const std::vector<HelperOp>& ops)
+    {
+        std::ostringstream out;
+        out << manifestHeader << "\n";
+        for (const HelperOp& op : ops)
+        {
+            out << kindName(op.kind) << '\t' << op.source << '\t' << op.target;
+            if (op.kind == HelperOp::Kind::COPY)
+            {
+                out << '\t' << op.sha256;
+            }
+            out << '\n';
+        }
+        return out.str();
+    }
+
+    bool readManifest(std::istream& in, std::vector<HelperOp>& ops)
+    {
+        std::string line;
+        if (!std::getline(in, line) || line != manifestHeader)
+        {
+            return false;
+        }
+
+        while (std::getline(in, line))
+        {
+            if (line.empty()) continue;
+
+            const size_t first = line.find('\t');
+            const size_t second = first == std::string::npos ? first : line.find('\t', first + 1);
+            if (second == std::string::npos) return false;
+
+            const std::string kind = line.substr(0, first);
+            HelperOp op;
+            op.source = line.substr(first + 1, second - first - 1);
+            op.target = line.substr(second + 1);
+
+            if (kind == "mkdir") op.kind = HelperOp::Kind::MKDIR;
+            else if (kind == "copy") op.kind = HelperOp::Kind::COPY;
+            else if (kind == "remove") op.kind = HelperOp::Kind::REMOVE;
+            else return false;
+
+            if (op.kind == HelperOp::Kind::COPY)
+            {
+                const size_t third = op.target.find('\t');
+                if (third == std::string::npos) return false;
+                op.sha256 = op.target.substr(third + 1);
+                op.target.resize(third);
+                if (op.sha256.size() != 64) return false;
+            }
+
+            ops.push_back(op);
+        }
+
+        return true;
+    }
+
+    std::filesystem::path normalRoot(const std::string& root)
+    {
+        std::filesystem::path path = std::filesystem::absolute(root).lexically_normal();
+        if (path.has_filename()) return path;
+        return path.parent_path();
+    }
+
+    bool isInside(const std::string& target, const std::string& root)
+    {
+        if (root.empty() || target.empty()) return false;
+
+        const std::filesystem::path base = normalRoot(root);
+        const std::filesystem::path path = std::filesystem::absolute(target).lexically_normal();
+        auto mismatch = std::mismatch(base.begin(), base.end(), path.begin(), path.end());
+        return mismatch.first == base.end();
+    }
+
+    // In a private folder, so nobody can swap the manifest between writing and the helper reading it.
+    std::string tempManifestPath()
+    {
+        const std::string dir = makePrivateTempDir("sine-helper");
+        return dir.empty() ? "" : (std::filesystem::path(dir) / "manifest.txt").string();
+    }
+
+    void removeManifestFile(const std::string& path)
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(std::filesystem::path(path).parent_path(), ec);
+    }
+
+    // Copies a staged file the caller hashed, reading it once from a descriptor that
+    // cannot have been swapped for a symlink, and only puts it in place when the
+    // bytes copied match the digest.
+    bool copyVerified(const HelperOp& op, std::error_code& ec)
+    {
+        const std::string partial = op.target + ".sine-new";
+        Sha256 hash;
+        std::vector<char> chunk(1 << 16);
+        {
+#ifdef _WIN32
+            if (!std::filesystem::is_regular_file(std::filesystem::symlink_status(op.source, ec)))
+            {
+                if (!ec) ec = std::make_error_code(std::errc::operation_not_permitted);
+                return false;
+            }
+            std::ifstream in(op.source, std::ios::binary);
+            if (!in)
+            {
+                ec = std::make_error_code(std::errc::no_such_file_or_directory);
+                return false;
+            }
+#else
+            const int in = open(op.source.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+            if (in < 0)
+            {
+                ec = std::error_code(errno, std::generic_category());
+                return false;
+            }
+            struct stat st;
+            if (fstat(in, &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                close(in);
+                ec = std::make_error_code(std::errc::operation_not_permitted);
+                return false;
+            }
+#endif
+            std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+            for (;;)
+            {
+#ifdef _WIN32
+                in.read(chunk.data(), chunk.size());
+                const std::streamsize got = in.gcount();
+                if (in.bad())
+                {
+                    ec = std::make_error_code(std::errc::io_error);
+                    break;
+                }
+#else
+                const ssize_t got = read(in, chunk.data(), chunk.size());
+                if (got < 0 && errno == EINTR) continue;
+                if (got < 0)
+                {
+                    ec = std::error_code(errno, std::generic_category());
+                    break;
+                }
+#endif
+                if (got == 0) break;
+                hash.update(chunk.data(), static_cast<size_t>(got));
+                out.write(chunk.data(), got);
+            }
+#ifndef _WIN32
+            close(in);
+#endif
+            out.close();
+            if (!ec && !out)
+            {
+                ec = std::make_error_code(std::errc::io_error);
+            }
+        }
+
+        if (!ec && hash.finishHex() != op.sha256)
+        {
+            std::cerr << op.source << " does not match its digest.\n";
+            ec = std::make_error_code(std::errc::operation_not_permitted);
+        }
+        if (!ec)
+        {
+            std::filesystem::rename(partial, op.target, ec);
+        }
+        if (ec)
+        {
+            std::error_code ignored;
+            std::filesystem::remove(partial, ignored);
+            return false;
+        }
+        return true;
+    }
+
+    bool writeManifestFile(const std::string& path, const std::string& manifest)
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << manifest;
+        return static_cast<bool>(file);
+    }
+}
+
+std::vector<HelperOp> planCopy(const std::string& stagedDir, const std::string& targetDir)
+{
+    std::vector<HelperOp> ops;
+    ops.push_back({ HelperOp::Kind::MKDIR, "", targetDir });
+
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(stagedDir, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        if (ec) break;
+
+        const std::filesystem::path relative = it->path().lexically_relative(stagedDir);
+        const std::string target = (std::filesystem::path(targetDir) / relative).string();
+
+        if (it->is_directory(ec))
+        {
+            ops.push_back({ HelperOp::Kind::MKDIR, "", target });
+        }
+        else
+        {
+            ops.push_back({ HelperOp::Kind::COPY, it->path().string(), target, sha256File(it->path().string()) });
+        }
+    }
+
+    return ops;
+}
+
+bool runPrivilegedHelper(const std::string& browserPath, const std::string& profilePath, const std::vector<HelperOp>& ops)
+{
+    const std::string exePath = getExecutablePath();
+    if (exePath.empty()) return false;
+
+    const std::string manifest = writeManifest(ops);
+
+#ifdef _WIN32
+    const std::string manifestPath = tempManifestPath();
+    if (manifestPath.empty()) return false;
+    if (!writeManifestFile(manifestPath, manifest))
+    {
+        removeManifestFile(manifestPath);
+        return false;
+    }
+
+    std::string parameters = "--helper \"" + manifestPath + "\" "
+        "--browser \"" + browserPath + "\" "
+        "--profile \"" + profilePath + "\"";
+
+    SHELLEXECUTEINFOA sei = { sizeof(sei) };
+    sei.fMask = SEE_MASK_NOCLOSEPROCESS;
+    sei.lpVerb = "runas";
+    sei.lpFile = exePath.c_str();
+    sei.nShow = SW_HIDE;
+    sei.lpParameters = parameters.c_str();
+
+    bool ok = false;
+    if (ShellExecuteExA(&sei) && sei.hProcess)
+    {
+        WaitForSingleObject(sei.hProcess, INFINITE);
+        DWORD exitCode = 1;
+        GetExitCodeProcess(sei.hProcess, &exitCode);
+        CloseHandle(sei.hProcess);
+        ok = exitCode == 0;
+    }
+
+    removeManifestFile(manifestPath);
+    return ok;
+
+#elif defined(__linux__)
+    // pkexec keeps stdin, so the manifest never touches the disk. The helper has
+    // no window, so none of the display variables need to be forwarded.
+    std::string cmd = "pkexec --disable-internal-agent " + shellEscape(exePath)
+        + " --helper -"
+        + " --browser " + shellEscape(browserPath)
+        + " --profile " + shellEscape(profilePath);
+
+    FILE* pipe = popen(cmd.c_str(), "w");
+    if (!pipe) return false;
+
+    fwrite(manifest.data(), 1, manifest.size(), pipe);
+    int result = pclose(pipe);
+    return WIFEXITED(result) && WEXITSTATUS(result) == 0;
+
+#elif defined(__APPLE__)
+    const std::string manifestPath = tempManifestPath();
+    if (manifestPath.empty()) return false;
+    if (!writeManifestFile(manifestPath, manifest))
+    {
+        removeManifestFile(manifestPath);
+        return false;
+    }
+
+    std::string cmd = shellEscape(exePath)
+        + " --helper " + shellEscape(manifestPath)
+        + " --browser " + shellEscape(browserPath)
+        + " --profile " + shellEscape(profilePath);
+
+    // AppleScript string literal: escape backslashes and double quotes.
+    std::string quoted = "\"";
+    for (char c : cmd)
+    {
+        if (c == '\\' || c == '"') quoted.push_back('\\');
+        quoted.push_back(c);
+    }
+    quoted.push_back('"');
+
+    std::string script = "do shell script " + quoted + " with administrator privileges";
+    int result = system(("osascript -e " + shellEscape(script)).c_str());
+
+    removeManifestFile(manifestPath);
+    return result == 0;
+
+#else
+    std::cerr << "Unsupported OS.\n";
+    return false;
+#endif
+}
+
+int runHelper(const std::string& manifestPath, const std::string& browserPath, const std::string& profilePath)
+{
+    std::vector<HelperOp> ops;
+    bool parsed;
+    if (manifestPath == "-")
+    {
+        parsed = readManifest(std::cin, ops);
+    }
+    else
+    {
+        std::ifstream file(manifestPath, std::ios::binary);
+        parsed = file && readManifest(file, ops);
+    }
+
+    if (!parsed)
+    {
+        std::cerr << "Invalid helper manifest.\n";
+        return 2;
+    }
+
+    // Refuse the whole manifest if anything points outside the folders we were started for.
+    for (const HelperOp& op : ops)
+    {
+        if (!isInside(op.target, browserPath) && !isInside(op.target, profilePath))
+        {
+            std::cerr << "Refusing to touch " << op.target << ".\n";
+            return 2;
+        }
+    }
+
+    int failures = 0;
+    for (const HelperOp& op : ops)
+    {
+        std::error_code ec;
+        switch (op.kind)
+        {
+        case HelperOp::Kind::MKDIR:
+            std::filesystem::create_directories(op.target, ec);
+            if (!ec) fixFilePerms(op.target);
+            break;
+        case HelperOp::Kind::COPY:
+            if (copyVerified(op, ec)) fixFilePerms(op.target);
+            break;
+        case HelperOp::Kind::REMOVE:
+            std::filesystem::remove(op.target, ec);
+            break;
+        }
+
+        if (ec)
+        {
+            std::cerr << kindName(op.kind) << " " << op.target << ": " << ec.message() << "\n";
+            ++failures;
+        }
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Privileged filesystem work handed to a minimal elevated copy of the installer.
+// The unprivileged process downloads and extracts into a staging folder; the
+// helper (started with --helper) only creates folders, copies staged files and
+// removes files below the browser and profile folders it was launched with.
+
+struct HelperOp
+{
+    enum class Kind
+    {
+        MKDIR,
+        COPY,
+        REMOVE
+    };
+
+    Kind kind;
+    std::string source;
+    std::string target;
+    // COPY only: what source has to hash to. The helper copies nothing else, and
+    // refuses symlinks and anything but regular files as sources.
+    std::string sha256;
+};
+
+// Unprivileged side: the operations that copy a staged tree into targetDir. The
+// staged tree should live in a private folder (makePrivateTempDir).
+std::vector<HelperOp> planCopy(const std::string& stagedDir, const std::string& targetDir);
+
+// Starts the elevated helper, passes it the manifest and waits for it to finish.
+bool runPrivilegedHelper(const std::string& browserPath, const std::string& profilePath, const std::vector<HelperOp>& ops);
+
+// Elevated side. manifestPath is a file, or "-" to read the manifest from stdin.
+int runHelper(const std::string& manifestPath, const std::string& browserPath, const std::string& profilePath);
@@ -0,0 +1,86 @@
+#include <inflate.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+
+#ifdef SINE_HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+namespace
+{
+#ifdef SINE_HAVE_LIBDEFLATE
+    struct FreeDecompressor
+    {
+        void operator()(libdeflate_decompressor* decompressor) const
+        {
+            libdeflate_free_decompressor(decompressor);
+        }
+    };
+
+    // Decompressors hold ~32 KiB of tables and are not thread-safe; one per thread.
+    libdeflate_decompressor* threadDecompressor()
+    {
+        thread_local std::unique_ptr<libdeflate_decompressor, FreeDecompressor> decompressor(
+            libdeflate_alloc_decompressor());
+        return decompressor.get();
+    }
+#endif
+
+    bool initialChoice()
+    {
+#ifdef SINE_HAVE_LIBDEFLATE
+        const char* value = std::getenv("SINE_INFLATE");
+        return !value || std::string(value) != "minizip";
+#else
+        return false;
+#endif
+    }
+
+    std::atomic<bool> useLibdeflate{ initialChoice() };
+}
+
+bool inflateAvailable()
+{
+    return useLibdeflate;
+}
+
+const char* inflateBackend()
+{
+    return useLibdeflate ? "libdeflate" : "minizip";
+}
+
+bool setInflateBackend(const std::string& name)
+{
+    if (name == "minizip")
+    {
+        useLibdeflate = false;
+        return true;
+    }
+#ifdef SINE_HAVE_LIBDEFLATE
+    if (name == "libdeflate")
+    {
+        useLibdeflate = true;
+        return true;
+    }
+#endif
+    return false;
+}
+
+bool inflateRaw(const void* in, size_t inSize, void* out, size_t outSize)
+{
+#ifdef SINE_HAVE_LIBDEFLATE
+    libdeflate_decompressor* decompressor = threadDecompressor();
+    if (!decompressor) return false;
+
+    // A null actual size makes anything but exactly outSize bytes an error.
+    return libdeflate_deflate_decompress(decompressor, in, inSize, out, outSize, nullptr) == LIBDEFLATE_SUCCESS;
+#else
+    (void)in;
+    (void)inSize;
+    (void)out;
+    (void)outSize;
+    return false;
+#endif
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Inflates a whole raw deflate stream whose size is known up front, as zip entries
+// are. Builds with libdeflate (SINE_HAVE_LIBDEFLATE) use it, which decodes several
+// times faster than zlib; other builds have no backend here and extraction streams
+// every entry through minizip-ng's zlib instead.
+bool inflateAvailable();
+
+// "libdeflate", or "minizip" when entries stream through minizip-ng.
+const char* inflateBackend();
+
+// Picks the backend by name; returns false for one this build lacks. The
+// SINE_INFLATE environment variable sets the initial choice, e.g. SINE_INFLATE=minizip
+// to compare against the streaming path.
+bool setInflateBackend(const std::string& name);
+
+// Returns false unless in is a valid deflate stream of exactly outSize bytes.
+bool inflateRaw(const void* in, size_t inSize, void* out, size_t outSize);
@@ -0,0 +1,747 @@
+#include <install.h>
+#include <data.h>
+#include <delta.h>
+#include <extract.h>
+#include <mirrors.h>
+#include <net.h>
+#include <payload.h>
+#include <platform.h>
+#include <prefetch.h>
+#include <prefs.h>
+#include <profiles.h>
+#include <progress.h>
+#include <trace.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+
+std::string archiveUrl(const std::string& name, const Release& release)
+{
+    // program.zip and profile.zip are the bootloader; engine.zip and locales.zip Sine itself.
+    if (name == "program.zip" || name == "profile.zip")
+    {
+        return bootloaderReleases + release.boot + "/" + name;
+    }
+    return sineReleases + release.sine + "/" + name;
+}
+
+namespace
+{
+    // GitHub records the SHA-256 of every release asset when it is uploaded and
+    // serves it as the asset's "digest" in the releases API. That answer comes from
+    // api.github.com itself over verified TLS, never through a mirror, so a mirror
+    // cannot vouch for its own copy.
+    const std::string releasesApi = "https://api.github.com/repos/";
+
+    std::mutex publishedMutex;
+    // Release API URL -> asset download URL -> digest, fetched once per run.
+    std::map<std::string, std::map<std::string, std::string>> publishedReleases;
+
+    // ".../<owner>/<repo>/releases/download/<tag>/<asset>" -> ".../repos/<owner>/<repo>/releases/tags/<tag>"
+    std::string releaseApiUrl(const std::string& url)
+    {
+        const std::string github = "https://github.com/";
+        const size_t download = url.find("/releases/download/");
+        if (url.rfind(github, 0) != 0 || download == std::string::npos) return "";
+
+        const size_t tagBegin = download + strlen("/releases/download/");
+        const size_t tagEnd = url.find('/', tagBegin);
+        if (tagEnd == std::string::npos) return "";
+        return releasesApi + url.substr(github.size(), download - github.size())
+            + "/releases/tags/" + url.substr(tagBegin, tagEnd - tagBegin);
+    }
+
+    // The string value following "key": at pos, or empty when it is not a string (null).
+    std::string jsonString(const std::string& json, size_t pos, const std::string& key)
+    {
+        size_t i = json.find_first_not_of(" \t\r\n", pos + key.size() + 2);
+        if (i == std::string::npos || json[i] != ':') return "";
+        i = json.find_first_not_of(" \t\r\n", i + 1);
+        if (i == std::string::npos || json[i] != '"') return "";
+        const size_t end = json.find('"', i + 1);
+        return end == std::string::npos ? "" : json.substr(i + 1, end - i - 1);
+    }
+
+    // Every asset object lists "digest" before "browser_download_url", so each URL
+    // takes the digest found since the URL before it.
+    std::map<std::string, std::string> assetDigests(const std::string& json)
+    {
+        std::map<std::string, std::string> digests;
+        size_t previous = 0;
+        for (size_t at = json.find("\"browser_download_url\""); at != std::string::npos;
+             at = json.find("\"browser_download_url\"", at + 1))
+        {
+            const size_t digestAt = json.rfind("\"digest\"", at);
+            const std::string digest = digestAt != std::string::npos && digestAt >= previous
+                ? jsonString(json, digestAt, "digest") : "";
+            const std::string url = jsonString(json, at, "browser_download_url");
+            const bool hex = std::all_of(digest.begin() + std::min<size_t>(digest.size(), 7), digest.end(),
+                [](unsigned char c) { return std::isdigit(c) || (c >= 'a' && c <= 'f'); });
+            if (digest.size() == 7 + 64 && digest.rfind("sha256:", 0) == 0 && hex && !url.empty())
+            {
+                digests[url] = digest.substr(7);
+            }
+            previous = at;
+        }
+        return digests;
+    }
+
+    std::string publishedDigest(const std::string& url)
+    {
+        const std::string api = releaseApiUrl(url);
+        if (api.empty()) return "";
+
+        std::lock_guard<std::mutex> lock(publishedMutex);
+        auto release = publishedReleases.find(api);
+        if (release == publishedReleases.end())
+        {
+            TraceSpan span("digests", "net", api);
+            std::string json;
+            if (!fetchDocument(api, 1 << 20, json, { "Accept: application/vnd.github+json", "User-Agent: sine-installer" }))
+            {
+                // Not remembered, so a later attempt (a retried download) asks again.
+                return "";
+            }
+            release = publishedReleases.emplace(api, assetDigests(json)).first;
+        }
+
+        auto digest = release->second.find(url);
+        return digest == release->second.end() ? "" : digest->second;
+    }
+}
+
+std::string pinnedDigest(const std::string& fileName, const Release& release)
+{
+    auto it = release.digests.find(fileName);
+    return it == release.digests.end() ? publishedDigest(archiveUrl(fileName, release)) : it->second;
+}
+
+bool digestAvailable(const std::string& fileName, const Release& release)
+{
+    if (!pinnedDigest(fileName, release).empty()) return true;
+
+    std::cerr << "No digest for " << fileName << ", neither pinned nor published; refusing to install it unverified.\n";
+    progressError("sha256", 0, fileName + ": no digest");
+    return false;
+}
+
+bool downloadArchive(const std::string& downloadsFolder, const std::string& name, const Release& release)
+{
+    return digestAvailable(name, release) && downloadMirrored(archiveUrl(name, release), downloadsFolder + "/" + name, pinnedDigest(name, release));
+}
+
+FetchResult fetchArchive(const std::string& downloadsFolder, const std::string& name)
+{
+    switch (prefetchStatus(name))
+    {
+    case PrefetchStatus::READY:
+        return FetchResult::DONE;
+    case PrefetchStatus::PENDING:
+        prefetchHurry();
+        return FetchResult::PENDING;
+    default:
+        return downloadArchive(downloadsFolder, name) ? FetchResult::DONE : FetchResult::FAILED;
+    }
+}
+
+namespace
+{
+    std::map<std::string, std::vector<char>> heldArchives;
+}
+
+bool extractArchive(const std::string& downloadsFolder, const std::string& name, const std::string& outputDir,
+    const EntryFilter& filter)
+{
+    TraceSpan span("archive", "extract", name);
+    if (const PayloadEntry* entry = findPayload(name))
+    {
+        return extractZipBuffer(entry->data, entry->size, outputDir, name, filter);
+    }
+    auto held = heldArchives.find(name);
+    if (held != heldArchives.end())
+    {
+        return extractZipBuffer(held->second.data(), held->second.size(), outputDir, name, filter);
+    }
+    return extractZip(downloadsFolder + "/" + name, outputDir, filter);
+}
+
+bool holdArchives(const std::string& downloadsFolder, const std::vector<std::string>& names)
+{
+    for (const std::string& name : names)
+    {
+        if (findPayload(name)) continue;
+
+        const std::string path = downloadsFolder + "/" + name;
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        std::vector<char>& data = heldArchives[name];
+        data.resize(in ? static_cast<size_t>(in.tellg()) : 0);
+        in.seekg(0);
+        if (!in || !in.read(data.data(), static_cast<std::streamsize>(data.size())))
+        {
+            std::cerr << "Failed to read " << path << ".\n";
+            heldArchives.erase(name);
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace
+{
+    std::vector<std::string> fallbackLocales = { "en-US" };
+
+    std::string lowercase(std::string text)
+    {
+        std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return text;
+    }
+
+    std::string language(const std::string& tag)
+    {
+        return tag.substr(0, tag.find('-'));
+    }
+}
+
+void setFallbackLocales(const std::vector<std::string>& locales)
+{
+    fallbackLocales = locales;
+}
+
+std::vector<std::string> profileLocales(const std::string& profilePath)
+{
+    // The pref holds a string literal of comma separated tags: "\"de,en-US\"".
+    std::string requested = readPref(profilePath + "/prefs.js", "intl.locale.requested");
+    requested.erase(std::remove(requested.begin(), requested.end(), '"'), requested.end());
+
+    std::vector<std::string> locales;
+    size_t start = 0;
+    while (start < requested.size())
+    {
+        size_t comma = requested.find(',', start);
+        if (comma == std::string::npos) comma = requested.size();
+
+        std::string tag = requested.substr(start, comma - start);
+        tag.erase(std::remove(tag.begin(), tag.end(), ' '), tag.end());
+        if (!tag.empty()) locales.push_back(tag);
+        start = comma + 1;
+    }
+
+    if (locales.empty())
+    {
+        const std::string system = systemLocale();
+        if (!system.empty()) locales.push_back(system);
+    }
+
+    locales.insert(locales.end(), fallbackLocales.begin(), fallbackLocales.end());
+    return locales;
+}
+
+EntryFilter localeFilter(const std::string& profilePath)
+{
+    if (fallbackLocales.empty())
+    {
+        return nullptr;
+    }
+
+    std::vector<std::string> wanted;
+    for (const std::string& locale : profileLocales(profilePath))
+    {
+        wanted.push_back(lowercase(locale));
+    }
+
+    return [wanted](const std::string& name) {
+        // Only "locales/<tag>/..." is filtered; anything else is shared.
+        const std::string prefix = "locales/";
+        if (name.compare(0, prefix.size(), prefix) != 0) return true;
+        const size_t slash = name.find('/', prefix.size());
+        if (slash == std::string::npos) return true;
+
+        const std::string tag = lowercase(name.substr(prefix.size(), slash - prefix.size()));
+        for (const std::string& locale : wanted)
+        {
+            if (locale == tag || language(locale) == tag || locale == language(tag)) return true;
+        }
+        return false;
+    };
+}
+
+void pruneArchives(const std::string& downloadsFolder, const Release& release)
+{
+    TraceSpan span("prune archives", "fs");
+    std::error_code ec;
+    for (const char* archive : { "program.zip", "profile.zip", "engine.zip", "locales.zip" })
+    {
+        const std::string path = downloadsFolder + "/" + archive;
+        std::filesystem::remove(path + ".part", ec);
+
+        // The path of the release URL, which a mirror keeps; only the origin differs.
+        const std::string url = archiveUrl(archive, release);
+        const std::string releasePath = url.substr(url.find('/', url.find("://") + 3));
+        const std::string from = downloadedFrom(path);
+        const bool current = from.size() >= releasePath.size()
+            && from.compare(from.size() - releasePath.size(), releasePath.size(), releasePath) == 0;
+        if (!current)
+        {
+            std::filesystem::remove(path, ec);
+            std::filesystem::remove(path + ".validators", ec);
+        }
+    }
+}
+
+namespace
+{
+    const char* stampName = ".sine-version";
+
+    std::string browserStamp(const Release& release)
+    {
+        return "boot " + release.boot + "\n";
+    }
+
+    std::string profileStamp(const Release& release)
+    {
+        return "boot " + release.boot + "\nsine " + release.sine + "\n";
+    }
+
+    void writeStamp(const std::filesystem::path& dir, const std::string& contents)
+    {
+        std::ofstream file(dir / stampName, std::ios::binary | std::ios::trunc);
+        file << contents;
+    }
+
+    bool stampMatches(const std::filesystem::path& dir, const std::string& contents)
+    {
+        std::ifstream file(dir / stampName, std::ios::binary);
+        std::string stamp(contents.size() + 1, '\0');
+        file.read(&stamp[0], stamp.size());
+        return static_cast<size_t>(file.gcount()) == contents.size() && stamp.compare(0, contents.size(), contents) == 0;
+    }
+    // The versions a profile stamp names; empty when the stamp or a line is missing.
+    void readStamp(const std::filesystem::path& dir, std::string& boot, std::string& sine)
+    {
+        std::ifstream file(dir / stampName, std::ios::binary);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.rfind("boot ", 0) == 0) boot = line.substr(5);
+            else if (line.rfind("sine ", 0) == 0) sine = line.substr(5);
+        }
+    }
+}
+
+void writeBrowserStamp(const std::string& browserPath, const Release& release)
+{
+    writeStamp(browserPath, browserStamp(release));
+}
+
+void writeProfileStamp(const std::string& profilePath, const Release& release)
+{
+    writeStamp(std::filesystem::path(profilePath) / "chrome", profileStamp(release));
+}
+
+bool browserUpToDate(const std::string& browserPath, const Release& release)
+{
+    const std::filesystem::path browser = browserPath;
+    std::error_code ec;
+    return stampMatches(browser, browserStamp(release))
+        && std::filesystem::exists(browser / "config.js", ec)
+        && std::filesystem::exists(browser / "defaults" / "pref" / "config-prefs.js", ec);
+}
+
+bool profileUpToDate(const std::string& profilePath, const Release& release)
+{
+    const std::filesystem::path chrome = std::filesystem::path(profilePath) / "chrome";
+    std::error_code ec;
+    return stampMatches(chrome, profileStamp(release))
+        && std::filesystem::is_directory(chrome / "JS", ec)
+        && std::filesystem::is_directory(chrome / "utils", ec)
+        && std::filesystem::is_directory(chrome / "locales", ec)
+        && readPref(profilePath + "/prefs.js", "sine.version") == "\"" + release.sine + "\"";
+}
+
+void removeDir(std::string path)
+{
+    TraceSpan span("remove", "fs", path);
+    std::error_code ec;
+    std::filesystem::remove_all(path, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to remove " << path << ": " << ec.message() << "\n";
+    }
+}
+
+namespace
+{
+    const char* stagingName = ".sine-staging";
+    const char* previousName = ".sine-previous";
+
+    // What the profile archives own inside chrome; installs and rollbacks swap these as a whole.
+    const std::vector<std::string> ownedEntries = { "JS", "utils", "locales", stampName };
+
+    // Trades the owned entries of two trees, one rename each. An entry only one side
+    // has just moves over. Swapping twice restores both sides, which is how a swap
+    // that fails halfway is undone.
+    bool swapOwned(const std::filesystem::path& first, const std::filesystem::path& second, std::string& error)
+    {
+        TraceSpan span("swap", "fs", second.string());
+        std::vector<std::string> swapped;
+        for (const std::string& name : ownedEntries)
+        {
+            std::error_code ec;
+            const std::filesystem::path a = first / name;
+            const std::filesystem::path b = second / name;
+            const bool inFirst = std::filesystem::exists(a, ec);
+            const bool inSecond = std::filesystem::exists(b, ec);
+
+            bool ok = true;
+            if (inFirst && inSecond)
+            {
+                ok = exchangePaths(a.string(), b.string());
+            }
+            else if (inFirst || inSecond)
+            {
+                std::filesystem::rename(inFirst ? a : b, inFirst ? b : a, ec);
+                ok = !ec;
+            }
+
+            if (!ok)
+            {
+                error = "Failed to swap " + b.string() + ".";
+                for (auto it = swapped.rbegin(); it != swapped.rend(); ++it)
+                {
+                    const std::filesystem::path undoA = first / *it;
+                    const std::filesystem::path undoB = second / *it;
+                    if (std::filesystem::exists(undoA, ec) && std::filesystem::exists(undoB, ec))
+                    {
+                        exchangePaths(undoA.string(), undoB.string());
+                    }
+                    else if (std::filesystem::exists(undoA, ec))
+                    {
+                        std::filesystem::rename(undoA, undoB, ec);
+                    }
+                    else
+                    {
+                        std::filesystem::rename(undoB, undoA, ec);
+                    }
+                }
+                return false;
+            }
+            swapped.push_back(name);
+        }
+        return true;
+    }
+
+    // Makes the staged tree live. What was live before becomes the rollback
+    // generation, replacing the one kept from the install before.
+    bool commitStaging(const std::string& profilePath, std::string& error)
+    {
+        const std::filesystem::path chrome = std::filesystem::path(profilePath) / "chrome";
+        const std::filesystem::path staging = chrome / stagingName;
+        std::error_code ec;
+        std::filesystem::create_directories(staging, ec);
+
+        // Anything the archives put next to the owned folders is not versioned and
+        // simply replaces the live copy, as extracting in place would have.
+        for (const auto& entry : std::filesystem::directory_iterator(staging, ec))
+        {
+            const std::string name = entry.path().filename().string();
+            if (std::find(ownedEntries.begin(), ownedEntries.end(), name) != ownedEntries.end()) continue;
+
+            std::filesystem::copy(entry.path(), chrome / name,
+                std::filesystem::copy_options::recursive | std::filesystem::copy_options::overwrite_existing, ec);
+            if (ec)
+            {
+                error = "Failed to install " + (chrome / name).string() + ": " + ec.message() + ".";
+                return false;
+            }
+        }
+
+        if (!swapOwned(staging, chrome, error))
+        {
+            return false;
+        }
+
+        // The live tree is complete from here on; the rest is housekeeping.
+        for (const auto& entry : std::filesystem::directory_iterator(staging, ec))
+        {
+            const std::string name = entry.path().filename().string();
+            if (std::find(ownedEntries.begin(), ownedEntries.end(), name) == ownedEntries.end())
+            {
+                std::filesystem::remove_all(entry.path(), ec);
+            }
+        }
+        removeDir((chrome / previousName).string());
+        std::filesystem::rename(staging, chrome / previousName, ec);
+        return true;
+    }
+
+    // Fills staging with hard links to the live owned folders, copies where the
+    // filesystem has no links. A delta applied there replaces files by renaming, so
+    // it never writes through a link into the live tree. The stamp is left out: it
+    // is rewritten in place once the update is live.
+    bool cloneOwned(const std::filesystem::path& chrome, const std::filesystem::path& staging)
+    {
+        TraceSpan span("clone", "fs", staging.string());
+        std::error_code ec;
+        for (const std::string& name : ownedEntries)
+        {
+            if (name == stampName || !std::filesystem::is_directory(chrome / name, ec)) continue;
+
+            std::filesystem::create_directories(staging / name, ec);
+            for (auto it = std::filesystem::recursive_directory_iterator(chrome / name, ec);
+                !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+            {
+                const std::filesystem::path target = staging / name / std::filesystem::relative(it->path(), chrome / name);
+                if (it->is_directory())
+                {
+                    std::filesystem::create_directories(target, ec);
+                    continue;
+                }
+                std::filesystem::create_hard_link(it->path(), target, ec);
+                if (ec)
+                {
+                    ec.clear();
+                    std::filesystem::copy_file(it->path(), target, ec);
+                }
+                if (ec) return false;
+            }
+            if (ec) return false;
+        }
+        return true;
+    }
+}
+
+void cleanProfile(const std::string& profilePath)
+{
+    std::error_code ec;
+    std::filesystem::remove(std::filesystem::path(profilePath) / "chrome" / stampName, ec);
+    removeDir(profilePath + "/chrome/JS");
+    removeDir(profilePath + "/chrome/utils");
+    removeDir(profilePath + "/chrome/locales");
+    removeDir(profilePath + "/chrome/" + stagingName);
+    removeDir(profilePath + "/chrome/" + previousName);
+}
+
+namespace
+{
+    // Records the installed version in prefs.js and, when everything before went through, the profile stamp.
+    bool finishProfile(const std::string& profilePath, std::string& error, const Release& release = compiledRelease())
+    {
+        const std::vector<PrefValue> prefs = {
+            { "sine.is-cosine", isCosine ? "true" : "false" },
+            { "sine.version", "\"" + release.sine + "\"" },
+            { "sine.latest-version", "\"" + release.sine + "\"" }
+        };
+        if (!upsertPrefs(profilePath + "/prefs.js", prefs) && error.empty())
+        {
+            error = "Failed to update prefs.js.";
+        }
+
+        // Only a complete install gets stamped, so a failed one is redone next time.
+        if (error.empty())
+        {
+            writeProfileStamp(profilePath, release);
+        }
+
+        return error.empty();
+    }
+}
+
+bool stageProfile(const std::string& downloadsFolder, const std::string& profilePath, std::string& error)
+{
+    const std::string staging = profilePath + "/chrome/" + stagingName;
+    // Whatever an interrupted install left behind.
+    removeDir(staging);
+
+    const EntryFilter locales = localeFilter(profilePath);
+    for (const char* archive : { "profile.zip", "engine.zip", "locales.zip" })
+    {
+        const bool isLocales = strcmp(archive, "locales.zip") == 0;
+        if (!extractArchive(downloadsFolder, archive, staging, isLocales ? locales : nullptr))
+        {
+            error = "Failed to extract " + std::string(archive) + ".";
+        }
+    }
+
+    if (!error.empty())
+    {
+        removeDir(staging);
+        return false;
+    }
+    return true;
+}
+
+bool profileStaged(const std::string& profilePath)
+{
+    std::error_code ec;
+    return std::filesystem::is_directory(profilePath + "/chrome/" + stagingName, ec);
+}
+
+bool commitProfile(const std::string& profilePath, std::string& error, const Release& release)
+{
+    if (!profileStaged(profilePath))
+    {
+        error = "Nothing is staged for " + profilePath + ".";
+        return false;
+    }
+
+    // A failure up to here left the live tree as it was.
+    if (!commitStaging(profilePath, error))
+    {
+        removeDir(profilePath + "/chrome/" + stagingName);
+        return false;
+    }
+
+    return finishProfile(profilePath, error, release);
+}
+
+bool configureProfile(const std::string& downloadsFolder, const std::string& profilePath, std::string& error)
+{
+    return stageProfile(downloadsFolder, profilePath, error) && commitProfile(profilePath, error);
+}
+
+std::string deltaUrl(const std::string& name, const std::string& baseVersion)
+{
+    // "engine.zip" from 1.2.0 -> ".../engine-from-1.2.0.delta"
+    return sineReleases + sineVersion + "/" + name.substr(0, name.rfind('.')) + "-from-" + baseVersion + ".delta";
+}
+
+namespace
+{
+    // Checked like the full archives: the compiled-in table (by file name, e.g.
+    // "engine-from-2.3b.delta"), else the digest GitHub published for the asset.
+    std::string deltaDigest(const std::string& url)
+    {
+        const Release& release = compiledRelease();
+        auto it = release.digests.find(url.substr(url.rfind('/') + 1));
+        return it == release.digests.end() ? publishedDigest(url) : it->second;
+    }
+}
+
+std::string deltaBaseVersion(const std::string& profilePath)
+{
+    const std::filesystem::path chrome = std::filesystem::path(profilePath) / "chrome";
+    std::string boot, sine;
+    readStamp(chrome, boot, sine);
+
+    // profile.zip belongs to the bootloader and has no deltas; a new bootloader means the full install.
+    std::error_code ec;
+    if (boot != bootVersion || sine.empty() || sine == sineVersion
+        || !std::filesystem::is_directory(chrome / "JS", ec)
+        || !std::filesystem::is_directory(chrome / "locales", ec))
+    {
+        return "";
+    }
+    return sine;
+}
+
+bool updateProfileFromDelta(const std::string& downloadsFolder, const std::string& profilePath, const std::string& baseVersion)
+{
+    const std::string chrome = profilePath + "/chrome";
+    const std::string staging = chrome + "/" + stagingName;
+    std::string error;
+    std::error_code ec;
+
+    // Patched in a linked copy of the live tree, which goes live in one swap like a full install.
+    removeDir(staging);
+    bool ok = cloneOwned(chrome, staging);
+    const EntryFilter locales = localeFilter(profilePath);
+    for (const char* archive : { "engine.zip", "locales.zip" })
+    {
+        if (!ok) break;
+        const std::string deltaPath = downloadsFolder + "/" + archive + ".delta";
+        const bool isLocales = strcmp(archive, "locales.zip") == 0;
+        // The package carries the hashes applyDelta() checks, so it is only as good as
+        // its own digest; without one the full install (verified in turn) takes over.
+        const std::string url = deltaUrl(archive, baseVersion);
+        const std::string digest = deltaDigest(url);
+        if (digest.empty())
+        {
+            std::cerr << "No digest for " << url << "; installing the full archives instead.\n";
+            ok = false;
+            break;
+        }
+        ok = downloadMirrored(url, deltaPath, digest)
+            && applyDelta(deltaPath, staging, baseVersion, sineVersion, error, isLocales ? locales : nullptr);
+        std::filesystem::remove(deltaPath, ec);
+    }
+    ok = ok && commitStaging(profilePath, error);
+
+    if (!ok)
+    {
+        removeDir(staging);
+        if (!error.empty())
+        {
+            std::cerr << error << "\n";
+            progressError("delta", 0, error);
+        }
+        return false;
+    }
+
+    return finishProfile(profilePath, error);
+}
+
+bool rollbackProfile(const std::string& profilePath, std::string& error)
+{
+    const std::filesystem::path chrome = std::filesystem::path(profilePath) / "chrome";
+    const std::filesystem::path previous = chrome / previousName;
+
+    std::string boot, sine;
+    readStamp(previous, boot, sine);
+    if (sine.empty())
+    {
+        error = "There is no previous version to roll back to.";
+        return false;
+    }
+
+    if (!swapOwned(previous, chrome, error))
+    {
+        return false;
+    }
+
+    const std::vector<PrefValue> prefs = { { "sine.version", "\"" + sine + "\"" } };
+    if (!upsertPrefs(profilePath + "/prefs.js", prefs))
+    {
+        error = "Failed to update prefs.js.";
+        return false;
+    }
+
+    reportStream() << "Rolled back to Sine " << sine << ".\n";
+    return true;
+}
+
+void removeMods(const std::string& profilePath)
+{
+    if (std::filesystem::exists(std::filesystem::path(profilePath) / "chrome" / "sine-mods"))
+    {
+        TraceSpan span("remove", "fs", profilePath + "/chrome/sine-mods");
+        std::filesystem::remove_all(profilePath + "/chrome/sine-mods");
+    }
+}
+
+void clearStartupCache(std::string profilePath)
+{
+    // The cache sits next to the profile under the local (not roaming) app data
+    // folder. On Linux it is under ~/.cache, which the user clears from about:support.
+    if (getOS() == "win32")
+    {
+        size_t pos = profilePath.find("Roaming");
+        if (pos != std::string::npos)
+        {
+            removeDir(profilePath.replace(pos, 7, "Local") + "/startupCache");
+        }
+    }
+    else if (getOS() == "darwin")
+    {
+        size_t pos = profilePath.find("Application Support");
+        if (pos != std::string::npos)
+        {
+            removeDir(profilePath.replace(pos, 19, "Caches") + "/startupCache");
+        }
+    }
+}
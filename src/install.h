@@ -0,0 +1,108 @@
+#pragma once
+
+#include <data.h>
+#include <extract.h>
+
+#include <string>
+#include <vector>
+
+// The install steps shared by the wizard (State::SIX) and the headless batch
+// mode. Archives live in downloadsFolder, or in the executable's payload for
+// offline builds. What takes a Release installs the compiled-in one unless told
+// otherwise; only --agent passes another.
+
+std::string archiveUrl(const std::string& name, const Release& release = compiledRelease());
+// The release's own digest for the archive, else the one GitHub published for the
+// release asset (fetched from api.github.com once per run). Empty when neither is known.
+std::string pinnedDigest(const std::string& fileName, const Release& release = compiledRelease());
+// False (and says so) when no digest for the archive is known, which is then not
+// downloaded at all rather than installed unverified.
+bool digestAvailable(const std::string& fileName, const Release& release = compiledRelease());
+
+bool downloadArchive(const std::string& downloadsFolder, const std::string& name, const Release& release = compiledRelease());
+
+enum class FetchResult
+{
+    DONE,
+    PENDING,
+    FAILED
+};
+
+// The wizard's download step: takes the prefetched copy when there is one, reports
+// PENDING (without blocking the frame) while it is still arriving, and otherwise
+// downloads directly, which also retries a failed prefetch.
+FetchResult fetchArchive(const std::string& downloadsFolder, const std::string& name);
+bool extractArchive(const std::string& downloadsFolder, const std::string& name, const std::string& outputDir,
+    const EntryFilter& filter = nullptr);
+// Reads the archives into memory, where extractArchive() takes them from instead of
+// downloadsFolder. For work that goes on in a process that can no longer read it,
+// like the --all-users children that give up root (see batch.cpp).
+bool holdArchives(const std::string& downloadsFolder, const std::vector<std::string>& names);
+
+// locales.zip holds one "locales/<tag>/" subtree per language, of which a profile
+// only needs its own. Kept are the locales the profile requests in prefs.js
+// (intl.locale.requested, or the system locale when that is unset) plus the
+// fallbacks, en-US unless --locales says otherwise. An empty fallback list from
+// "--locales all" turns the filtering off.
+void setFallbackLocales(const std::vector<std::string>& locales);
+std::vector<std::string> profileLocales(const std::string& profilePath);
+// Null (extract everything) when filtering is off. A bare language matches its
+// regional variants and the other way round.
+EntryFilter localeFilter(const std::string& profilePath);
+// The archives stay in downloadsFolder (a cache, see main.cpp) between runs, with
+// their validators, so the next install of the same release costs a 304 per
+// archive. This drops the archives of any other release and partial downloads.
+void pruneArchives(const std::string& downloadsFolder, const Release& release = compiledRelease());
+
+void removeDir(std::string path);
+
+// Profile installs are staged: the archives go into chrome/.sine-staging, on the
+// same filesystem as the live tree, which stays untouched until everything is in
+// place. Then each folder the archives own (JS, utils, locales) and the stamp trade
+// places with the staged one in a single rename, and what was live is kept as
+// chrome/.sine-previous, the generation rollbackProfile() brings back.
+
+// Removes everything the profile archives installed, the rollback generation included.
+void cleanProfile(const std::string& profilePath);
+// Extracts profile.zip, engine.zip and locales.zip into the profile's chrome
+// folder and records the installed version in prefs.js. A failure leaves the
+// installed version in place.
+bool configureProfile(const std::string& downloadsFolder, const std::string& profilePath, std::string& error);
+// configureProfile() in two halves, for --agent: stageProfile() extracts into
+// staging without touching anything live, so it can run while the browser is
+// open; commitProfile() swaps it in and records the version once it is closed.
+bool stageProfile(const std::string& downloadsFolder, const std::string& profilePath, std::string& error);
+bool profileStaged(const std::string& profilePath);
+bool commitProfile(const std::string& profilePath, std::string& error, const Release& release = compiledRelease());
+
+// Delta updates (see delta.h) of engine.zip and locales.zip from the Sine version
+// a profile already has, published next to the full archives as the archive's name
+// without ".zip" plus "-from-<base version>.delta" ("engine-from-2.3b.delta").
+// Each is checked against a digest like the full archives before it is applied.
+std::string deltaUrl(const std::string& name, const std::string& baseVersion);
+// The installed Sine version when the profile can be updated by delta: its stamp
+// names the current bootloader and an older Sine. Empty when it needs the full install.
+std::string deltaBaseVersion(const std::string& profilePath);
+// Downloads and applies both deltas, then records the new version like configureProfile.
+// False when a delta is missing or does not fit the installed files; the caller then
+// goes through the full download, clean and configure steps.
+bool updateProfileFromDelta(const std::string& downloadsFolder, const std::string& profilePath, const std::string& baseVersion);
+
+// Swaps chrome/.sine-previous back in (--rollback) and points sine.version at it.
+// The generation rolled back from takes its place, so a second rollback undoes the
+// first. The profile's stamp then names the older version, so the next update
+// installs the current one again.
+bool rollbackProfile(const std::string& profilePath, std::string& error);
+
+void removeMods(const std::string& profilePath);
+void clearStartupCache(std::string profilePath);
+
+// Version stamps (".sine-version") written next to what the archives installed:
+// into the browser folder with program.zip and into the profile's chrome folder
+// with the profile archives. A location is up to date when its stamp matches the
+// release's versions and the files the archives own are still there.
+void writeBrowserStamp(const std::string& browserPath, const Release& release = compiledRelease());
+void writeProfileStamp(const std::string& profilePath, const Release& release = compiledRelease());
+bool browserUpToDate(const std::string& browserPath, const Release& release = compiledRelease());
+// Also requires sine.version in prefs.js to match.
+bool profileUpToDate(const std::string& profilePath, const Release& release = compiledRelease());
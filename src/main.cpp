@@ -16,18 +16,38 @@
 #include <vector>
 #include <chrono>
 #include <array>
+#include <optional>
 #include <string>
 
 #include <algorithm>
 #include <cctype>
 #include <cstring>
 
+#include <agent.h>
+#include <batch.h>
 #include <data.h>
+#include <deferred.h>
+#include <extract.h>
+#include <frames.h>
+#include <helper.h>
+#include <install.h>
+#include <mirrors.h>
+#include <net.h>
+#include <payload.h>
+#include <platform.h>
+#include <preflight.h>
+#include <prefetch.h>
+#include <profiles.h>
+#include <progress.h>
+#include <throttle.h>
+#include <trace.h>
+#include <verify.h>
 #include <stdlib.h>
 #include <cstdlib>
 #include <filesystem>
 #include <sys/stat.h>
 #include <fstream>
+#include <sstream>
 
 #include <minizip-ng/mz.h>
 #include <minizip-ng/mz_strm.h>
@@ -82,6 +102,12 @@ enum class State
 
 State state = State::START;
 
+// For the frame profiler's per-page timings, in State order.
+const char* const stateNames[] = { "START", "ONE", "TWO", "THREE", "FOUR", "FIVE", "SIX", "LAST", "END" };
+
+// Launch to first frame on screen; anything over it is reported (see --trace and the progress stream).
+constexpr double firstFrameBudgetMs = 250.0;
+
 void nextState() {
     int stateInt = static_cast<int>(state);
     state = static_cast<State>(stateInt + 1);
@@ -125,59 +151,6 @@ std::vector<std::string> getBrowserVersions(size_t browserIndex)
     return versionNames;
 }
 
-std::string getOS()
-{
-#if defined(_WIN32) || defined(_WIN64)
-    return "win32";
-#elif defined(__APPLE__) || defined(__MACH__)
-    return "darwin";
-#elif defined(__linux__)
-    return "linux";
-#else
-    return "unsupported";
-#endif
-}
-
-std::string getBrowserLocation(int browserIndex, int versionIndex)
-{
-    std::string os = getOS();
-    std::vector<std::string> browserPaths = browsers[browserIndex].second[versionIndex + 1].second.find(os)->second;
-    for (std::string path : browserPaths)
-    {
-        if (std::filesystem::exists(path))
-        {
-            return path;
-        }
-    }
-    return "";
-}
-
-std::string getProfileLocation(int browserIndex)
-{
-    std::string os = getOS();
-    std::string profilePath = browsers[browserIndex].second[0].second.find(os)->second[0];
-    
-    if (os == "win32")
-    {
-        std::filesystem::path appData = std::getenv("APPDATA");
-        profilePath = (appData / profilePath / "Profiles").string();
-    }
-    else
-    {
-        std::filesystem::path home = std::getenv("HOME");
-        if (os == "darwin")
-        {
-            profilePath = (home / "Library" / "Application Support" / profilePath / "Profiles").string();
-        }
-        else if (os == "linux")
-        {
-            profilePath = (home / profilePath).string();
-        }
-    }
-
-    return profilePath;
-}
-
 std::string toLowercase(std::string str) {
     std::transform(str.begin(), str.end(), str.begin(),
         [](unsigned char c) { return std::tolower(c); });
@@ -299,91 +272,6 @@ void renderFooter(ImFont* &font, float uiScale, ImVec2 windowSize, bool hideEnd
     ImGui::PopFont();
 }
 
-bool fixFilePerms(const std::string& filepath) {
-#ifdef _WIN32
-    // Remove read-only attribute
-    DWORD attrs = GetFileAttributesA(filepath.c_str());
-    if (attrs != INVALID_FILE_ATTRIBUTES)
-    {
-        SetFileAttributesA(filepath.c_str(), attrs & ~FILE_ATTRIBUTE_READONLY);
-    }
-
-    // Get current user SID
-    HANDLE hToken;
-    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken))
-    {
-        return false;
-    }
-
-    DWORD dwSize = 0;
-    GetTokenInformation(hToken, TokenUser, NULL, 0, &dwSize);
-    TOKEN_USER* pTokenUser = (TOKEN_USER*)malloc(dwSize);
-
-    if (!GetTokenInformation(hToken, TokenUser, pTokenUser, dwSize, &dwSize))
-    {
-        free(pTokenUser);
-        CloseHandle(hToken);
-        return false;
-    }
-
-    // Set owner to current user
-    DWORD result = SetNamedSecurityInfoA(
-        (LPSTR)filepath.c_str(),
-        SE_FILE_OBJECT,
-        OWNER_SECURITY_INFORMATION,
-        pTokenUser->User.Sid,
-        NULL, NULL, NULL
-    );
-
-    free(pTokenUser);
-    CloseHandle(hToken);
-
-    return (result == ERROR_SUCCESS);
-
-#else
-    struct stat st;
-    if (stat(filepath.c_str(), &st) != 0)
-        return false;
-
-    if (S_ISDIR(st.st_mode))
-    {
-        // Directories: 755
-        if (chmod(filepath.c_str(),
-                  S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0)
-            return false;
-    }
-    else
-    {
-        // Files: 644
-        if (chmod(filepath.c_str(),
-                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0)
-            return false;
-    }
-
-    return false;
-#endif
-}
-
-std::string shellEscape(const std::string& input)
-{
-    // POSIX shell-safe escaping using single quotes
-    // abc'def → 'abc'"'"'def'
-    std::string out;
-    out.reserve(input.size() + 2);
-
-    out.push_back('\'');
-    for (char c : input)
-    {
-        if (c == '\'')
-            out += "'\"'\"'";
-        else
-            out.push_back(c);
-    }
-    out.push_back('\'');
-
-    return out;
-}
-
 bool requestAdmin(const std::string& browserPath, const std::string& profilePath, bool shouldSaveData, bool shouldUninstall, bool reinstallBoot, bool showExitScreen)
 {
 #ifdef _WIN32
@@ -515,202 +403,390 @@ bool isUserAdmin()
 #endif
 }
 
-bool canWriteToFolder(const std::filesystem::path& folder)
-{
-    try
-    {
-        if (!std::filesystem::exists(folder))
-        {
-            std::cerr << "Folder does not exist.\n";
-            return false;
-        }
-
-        std::filesystem::path testFile = folder / "temp_write_test.tmp";
-
-        std::ofstream ofs(testFile);
-        if (!ofs)
-        {
-            // Could not open file for writing
-            return false;
-        }
-
-        ofs << "test"; // Try writing something
-        ofs.close();
-
-        std::filesystem::remove(testFile); // Clean up
-        return true;
-    }
-    catch (...)
-    {
-        return false;
-    }
-}
-
-std::string getDownloadsFolder()
+// Where the archives are downloaded to and kept between runs: the user's cache
+// folder rather than Downloads, created private to the user.
+std::string getCacheFolder()
 {
+    std::filesystem::path cache;
 #ifdef _WIN32
     PWSTR path = NULL;
-    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_Downloads, 0, NULL, &path)))
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, NULL, &path)))
     {
-        char downloadsPath[MAX_PATH];
-        wcstombs(downloadsPath, path, MAX_PATH);
+        char localAppData[MAX_PATH];
+        wcstombs(localAppData, path, MAX_PATH);
         CoTaskMemFree(path);
-        return std::string(downloadsPath);
+        cache = std::filesystem::path(localAppData) / "sine-installer" / "cache";
+    }
+    else
+    {
+        cache = std::filesystem::temp_directory_path() / "sine-installer";
     }
-    return "C:\\Users\\Default\\Downloads";
 #else
     const char* home = std::getenv("HOME");
-    return std::string(home ? home : "/tmp") + "/Downloads";
+#ifdef __APPLE__
+    cache = std::filesystem::path(home ? home : "/tmp") / "Library" / "Caches" / "sine-installer";
+#else
+    const char* xdgCache = std::getenv("XDG_CACHE_HOME");
+    cache = xdgCache && *xdgCache ? std::filesystem::path(xdgCache) / "sine-installer"
+        : std::filesystem::path(home ? home : "/tmp") / ".cache" / "sine-installer";
+#endif
 #endif
-}
 
-size_t writeData(void* ptr, size_t size, size_t nmemb, void* stream)
-{
-    std::ofstream* out = static_cast<std::ofstream*>(stream);
-    out->write(static_cast<char*>(ptr), size * nmemb);
-    return size * nmemb;
+    std::error_code ec;
+    std::filesystem::create_directories(cache, ec);
+    std::filesystem::permissions(cache, std::filesystem::perms::owner_all, ec);
+    return cache.string();
 }
 
-bool downloadFile(const std::string& url, const std::string& outputPath)
+// Extracts program.zip unprivileged into a staging folder, then lets the elevated
+// helper copy the staged files into the browser folder.
+bool installBrowserViaHelper(const std::string& downloadsFolder, const std::string& browserPath, const std::string& profilePath)
 {
-    CURL* curl = curl_easy_init();
-    if (!curl) return false;
-
-    std::ofstream file(outputPath, std::ios::binary);
-    if (!file.is_open()) return false;
-
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeData);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &file);
-    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
-
-    CURLcode res = curl_easy_perform(curl);
-    curl_easy_cleanup(curl);
-    file.close();
+    // Private to this user: the helper copies what it finds here into a folder every user runs code from.
+    const std::string staging = makePrivateTempDir("sine-staging");
+    if (staging.empty())
+    {
+        std::cerr << "Failed to create a staging folder.\n";
+        return false;
+    }
 
-    if (res == CURLE_OK)
+    bool ok = extractArchive(downloadsFolder, "program.zip", staging);
+    if (ok)
     {
-        fixFilePerms(outputPath);
+        writeBrowserStamp(staging);
+        ok = runPrivilegedHelper(browserPath, profilePath, planCopy(staging, browserPath));
     }
 
-    return (res == CURLE_OK);
+    removeDir(staging);
+    return ok;
 }
 
-void extractZip(const std::string& zipPath, const std::string& outputDir)
+int main(int argc, char* argv[])
 {
-    std::filesystem::create_directories(outputDir);
-    fixFilePerms(outputDir);
-
-    void* reader = mz_zip_reader_create();
-    mz_zip_reader_open_file(reader, zipPath.c_str());
-    mz_zip_reader_goto_first_entry(reader);
+    const auto launched = steady_clock::now();
+    std::string browserPathStr;
+    std::string profilePath;
+    bool reinstallBoot = true;
+    bool shouldSaveData = false;
+    bool shouldUninstall = false;
+    bool showExitScreen = true;
+    bool verifyOnly = false;
+    bool rollback = false;
+    std::string archiveDir;
+    std::string helperManifest;
+    std::string tracePath;
+    int progressFd = -1;
+    bool allProfiles = false;
+    bool allUsers = false;
+    unsigned jobs = 0;
+    bool prefetch = true;
+    bool forceInstall = false;
+    int64_t prefetchLimit = 0;
+    bool background = false;
+    int64_t networkLimit = -1;
+    int64_t writeLimit = -1;
+    bool profileUi = false;
+    bool agent = false;
+    std::string releaseEndpoint;
+    int64_t checkInterval = 360;
 
-    do
+    for (int i = 1; i < argc; ++i)
     {
-        mz_zip_file* file_info = nullptr;
-        mz_zip_reader_entry_get_info(reader, &file_info);
-
-        std::string outPath = outputDir + "/" + file_info->filename;
-
-        if (mz_zip_reader_entry_is_dir(reader) == MZ_OK)
+        std::string arg = argv[i];
+        if (arg == "--browser" && i + 1 < argc)
         {
-            std::filesystem::create_directories(outPath);
-            fixFilePerms(outPath);
+            browserPathStr = argv[i + 1];
+            ++i;
         }
-        else
+        else if (arg == "--profile" && i + 1 < argc)
         {
-            std::filesystem::create_directories(
-                std::filesystem::path(outPath).parent_path());
-
-            fixFilePerms(std::filesystem::path(outPath).parent_path().string());
-
-            // Read entry data into buffer
-            mz_zip_reader_entry_open(reader);
-
-            std::vector<uint8_t> buffer(file_info->uncompressed_size);
-            int32_t bytes_read = mz_zip_reader_entry_read(reader, buffer.data(), buffer.size());
-
-            mz_zip_reader_entry_close(reader);
-
-            // Write buffer to file
-            std::ofstream outFile(outPath, std::ios::binary);
-            outFile.write(reinterpret_cast<char*>(buffer.data()), bytes_read);
-            outFile.close();
-
-            fixFilePerms(outPath);
+            profilePath = argv[i + 1];
+            ++i;
         }
-    } while (mz_zip_reader_goto_next_entry(reader) == MZ_OK);
-
-    mz_zip_reader_close(reader);
-    mz_zip_reader_delete(&reader);
-}
+        else if (arg == "--save" || arg == "-s")
+        {
+            shouldSaveData = true;
+        }
+        else if (arg == "--uninstall" || arg == "-u")
+        {
+            shouldUninstall = true;
+        }
+        else if (arg == "--no-boot")
+        {
+            reinstallBoot = false;
+        }
+        else if (arg == "--update")
+        {
+            showExitScreen = false;
+        }
+        else if (arg == "--verify")
+        {
+            verifyOnly = true;
+        }
+        else if (arg == "--rollback")
+        {
+            rollback = true;
+        }
+        else if (arg == "--archives" && i + 1 < argc)
+        {
+            archiveDir = argv[i + 1];
+            ++i;
+        }
+        else if (arg == "--helper" && i + 1 < argc)
+        {
+            helperManifest = argv[i + 1];
+            ++i;
+        }
+        else if (arg == "--trace" && i + 1 < argc)
+        {
+            tracePath = argv[i + 1];
+            ++i;
+        }
+        else if (arg == "--progress-fd" && i + 1 < argc)
+        {
+            progressFd = std::atoi(argv[i + 1]);
+            ++i;
+        }
+        else if (arg == "--json-progress")
+        {
+            progressFd = 1;
+        }
+        else if (arg == "--all-profiles")
+        {
+            allProfiles = true;
+        }
+        else if (arg == "--all-users")
+        {
+            allProfiles = true;
+            allUsers = true;
+        }
+        else if (arg == "--jobs" && i + 1 < argc)
+        {
+            jobs = static_cast<unsigned>(std::atoi(argv[i + 1]));
+            ++i;
+        }
+        else if (arg == "--force")
+        {
+            forceInstall = true;
+        }
+        else if (arg == "--locales" && i + 1 < argc)
+        {
+            // Fallback locales kept besides the profile's own, e.g. "en-US,de"; "all" keeps every locale.
+            std::vector<std::string> locales;
+            std::stringstream list(argv[i + 1]);
+            for (std::string tag; std::getline(list, tag, ',');)
+            {
+                if (!tag.empty()) locales.push_back(tag);
+            }
+            if (std::string(argv[i + 1]) == "all") locales.clear();
+            setFallbackLocales(locales);
+            ++i;
+        }
+        else if (arg == "--mirror" && i + 1 < argc)
+        {
+            // Origin standing in for https://github.com, e.g. an internal cache; may repeat.
+            addMirror(argv[i + 1]);
+            ++i;
+        }
+        else if (arg == "--no-prefetch")
+        {
+            prefetch = false;
+        }
+        else if (arg == "--prefetch-limit" && i + 1 < argc)
+        {
+            // KiB/s while the wizard is still open; lifted once the install waits on it.
+            prefetchLimit = std::atoll(argv[i + 1]) * 1024;
+            ++i;
+        }
+        else if (arg == "--background")
+        {
+            // For login scripts on shared hosts: low CPU and I/O priority plus the caps below.
+            background = true;
+        }
+        else if (arg == "--net-limit" && i + 1 < argc)
+        {
+            // MB/s across all downloads, 0 for none.
+            networkLimit = std::atoll(argv[i + 1]) << 20;
+            ++i;
+        }
+        else if (arg == "--write-limit" && i + 1 < argc)
+        {
+            // MB/s of extracted data, 0 for none.
+            writeLimit = std::atoll(argv[i + 1]) << 20;
+            ++i;
+        }
+        else if (arg == "--agent")
+        {
+            // Stays resident and updates --profile whenever its browser closes.
+            agent = true;
+        }
+        else if (arg == "--release-endpoint" && i + 1 < argc)
+        {
+            // Path or URL of the release manifest --agent follows.
+            releaseEndpoint = argv[i + 1];
+            ++i;
+        }
+        else if (arg == "--check-interval" && i + 1 < argc)
+        {
+            // Minutes between --agent's release checks.
+            checkInterval = std::atoll(argv[i + 1]);
+            ++i;
+        }
+        else if (arg == "--profile-ui")
+        {
+            // Frame-time overlay from the start (F12 toggles it either way), percentiles on exit.
+            profileUi = true;
+        }
+    }
 
-bool isProcessRunning(const std::string& processName) {
-#ifdef _WIN32
-    // Windows implementation
-    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    if (hSnapshot == INVALID_HANDLE_VALUE) {
-        return false;
+    // The elevated helper only touches the filesystem; skip everything else.
+    if (!helperManifest.empty())
+    {
+        return runHelper(helperManifest, browserPathStr, profilePath);
     }
 
-    PROCESSENTRY32 pe32;
-    pe32.dwSize = sizeof(PROCESSENTRY32);
+    if (!tracePath.empty())
+    {
+        traceOpen(tracePath);
+    }
 
-    if (Process32First(hSnapshot, &pe32)) {
-        do {
-            if (processName == pe32.szExeFile) {
-                CloseHandle(hSnapshot);
-                return true;
-            }
-        } while (Process32Next(hSnapshot, &pe32));
+    if (progressFd >= 0)
+    {
+        if (progressFd == 1)
+        {
+            attachConsole();
+        }
+        progressOpen(progressFd);
     }
 
-    CloseHandle(hSnapshot);
-    return false;
+    if (background || agent)
+    {
+        // Before any worker thread starts, so they all inherit it. The agent only
+        // ever works in the background, but its downloads need no caps.
+        lowerProcessPriority();
+    }
+    setNetworkLimit(networkLimit >= 0 ? networkLimit : background ? backgroundNetworkLimit : 0);
+    setWriteLimit(writeLimit >= 0 ? writeLimit : background ? backgroundWriteLimit : 0);
+
+    // Neither is needed for the first frame; every mode joins them where it first uses them.
+    const Deferred<bool> network([]() {
+        const bool ok = netInit();
+        addMirrorsFromEnvironment();
+        return ok;
+    });
+    const Deferred<std::string> downloads(getCacheFolder);
+    const bool offline = openPayload();
+
+    if (rollback)
+    {
+        attachConsole();
+        if (profilePath.empty())
+        {
+            std::cerr << "--rollback needs --profile.\n";
+            return 2;
+        }
 
-#elif __linux__
-    // Linux implementation
-    for (const auto& entry : std::filesystem::directory_iterator("/proc")) {
-        if (entry.is_directory()) {
-            std::string cmdlinePath = entry.path().string() + "/cmdline";
-            std::ifstream cmdline(cmdlinePath);
-            std::string content;
-            std::getline(cmdline, content, '\0');
-            if (content.find(processName) != std::string::npos) {
-                return true;
-            }
+        network.get();
+        std::string error;
+        const bool ok = rollbackProfile(profilePath, error);
+        if (ok)
+        {
+            clearStartupCache(profilePath);
+        }
+        else
+        {
+            std::cerr << error << "\n";
         }
+        closePayload();
+        netCleanup();
+        return ok ? 0 : 1;
     }
-    return false;
 
-#elif __APPLE__
-    // macOS implementation
-    std::string command = "pgrep -x " + processName;
-    std::array<char, 128> buffer;
-    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
-
-    if (!pipe) {
-        return false;
+    if (verifyOnly)
+    {
+        attachConsole();
+
+        VerifyOptions options;
+        options.browserPath = browserPathStr;
+        options.profilePath = profilePath;
+        options.archiveDir = archiveDir.empty() ? downloads.get() : archiveDir;
+
+        network.get();
+        int result = runVerify(options);
+        closePayload();
+        netCleanup();
+        return result;
     }
 
-    return fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr;
+    if (allProfiles)
+    {
+        attachConsole();
+        if (shouldUninstall)
+        {
+            std::cerr << "--uninstall cannot be combined with --all-profiles or --all-users.\n";
+            return 2;
+        }
 
-#else
-    // Unsupported platform
-    return false;
-#endif
-}
+        BatchOptions options;
+        options.allUsers = allUsers;
+        options.saveData = shouldSaveData;
+        options.browserPath = reinstallBoot ? browserPathStr : "";
+        options.downloadsFolder = downloads.get();
+        options.offline = offline;
+        options.jobs = jobs;
+        options.force = forceInstall;
+        network.get();
+        int result = runBatchInstall(options);
+
+        closePayload();
+        netCleanup();
+        traceClose();
+        progressClose();
+        return result;
+    }
 
-void removeDir(std::string path)
-{
-    if (std::filesystem::exists(path))
+    if (agent)
     {
-        std::filesystem::remove_all(path);
+        attachConsole();
+        if (profilePath.empty())
+        {
+            std::cerr << "--agent needs --profile.\n";
+            return 2;
+        }
+
+        AgentOptions options;
+        options.profilePath = profilePath;
+        options.browserPath = reinstallBoot ? browserPathStr : "";
+        options.downloadsFolder = downloads.get();
+        options.endpoint = releaseEndpoint;
+        options.intervalMinutes = checkInterval;
+        options.offline = offline;
+        options.saveData = shouldSaveData;
+        if (!network.get() && !offline)
+        {
+            std::cerr << "Failed to initialise the network.\n";
+            return 2;
+        }
+        runAgent(options);
     }
-}
 
-int main(int argc, char* argv[])
-{
+    // The rest of the wizard's startup work, off the path to the first frame.
+    const Deferred<bool> isAdmin(isUserAdmin);
+    const Deferred<BrowserLocations> locations(probeBrowserLocations);
+    const Deferred<bool> prefetching([=]() {
+        // The archives don't depend on anything the wizard asks, so fetch them while it is open.
+        // An unattended update of an install that is already current needs nothing at all.
+        const bool knownCurrent = !forceInstall && !browserPathStr.empty() && !profilePath.empty()
+            && profileUpToDate(profilePath) && (!reinstallBoot || browserUpToDate(browserPathStr));
+        const bool start = network.get() && prefetch && !offline && !shouldUninstall && !knownCurrent;
+        if (start)
+        {
+            prefetchStart(downloads.get(), prefetchLimit);
+        }
+        return start;
+    });
+
+    TraceSpan glfwSpan("glfw init", "startup");
     if (!glfwInit()) return -1;
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -723,6 +799,7 @@ int main(int argc, char* argv[])
 
     const int windowHeight = 900;
     const int windowWidth = 600;
+    TraceSpan windowSpan("window", "startup");
     GLFWwindow* window = glfwCreateWindow(windowHeight, windowWidth, "Sine Installer", nullptr, nullptr);
     if (!window) return -1;
 
@@ -764,27 +841,7 @@ int main(int argc, char* argv[])
     ImFontConfig cfg;
     cfg.FontDataOwnedByAtlas = false;
 
-    ImFont* mediumFont = io.Fonts->AddFontFromMemoryTTF(
-        CascadiaCode_Regular_ttf,
-        CascadiaCode_Regular_ttf_len,
-        22.0f * uiScale,
-        &cfg
-    );
-
-    ImFont* bodyFont = io.Fonts->AddFontFromMemoryTTF(
-        CascadiaCode_Regular_ttf,
-        CascadiaCode_Regular_ttf_len,
-        18.0f * uiScale,
-        &cfg
-    );
-
-    ImFont* lightFont = io.Fonts->AddFontFromMemoryTTF(
-        CascadiaCode_Light_ttf,
-        CascadiaCode_Light_ttf_len,
-        14.0f * uiScale,
-        &cfg
-    );
-
+    // The START page only needs the title font; the others follow once it is on screen.
     ImFont* titleFont = io.Fonts->AddFontFromMemoryTTF(
         CascadiaCode_Bold_ttf,
         CascadiaCode_Bold_ttf_len,
@@ -792,6 +849,16 @@ int main(int argc, char* argv[])
         &cfg
     );
 
+    ImFont* mediumFont = nullptr;
+    ImFont* bodyFont = nullptr;
+    ImFont* lightFont = nullptr;
+    int framesDrawn = 0;
+
+    if (profileUi)
+    {
+        frameProfileEnable();
+    }
+
     auto begin = high_resolution_clock::now();
     int selectedBrowser = 0;
     int selectedVersion = 0;
@@ -801,54 +868,25 @@ int main(int argc, char* argv[])
     char reason[128] = "";
     bool showHiddenProfiles = false;
     bool shouldReset = true;
-    std::string browserPathStr;
-    std::string profilePath;
-    bool reinstallBoot = true;
-    bool shouldSaveData = false;
-    bool shouldUninstall = false;
     int shouldNotify = 0;
-    bool isAdmin = isUserAdmin();
     bool shouldTryAdmin = true;
     int installStep = 0;
     int needsAdmin = -1;
-
-    bool showExitScreen = true;
-
-    const std::string downloadsFolder = getDownloadsFolder();
-
-    const std::string bootloaderReleases = "https://github.com/sineorg/bootloader/releases/download/v";
-    const std::string sineReleases = "https://github.com/CosmoCreeper/Sine/releases/download/v";
-
-    for (int i = 1; i < argc; ++i)
-    {
-        std::string arg = argv[i];
-        if (arg == "--browser" && i + 1 < argc)
-        {
-            browserPathStr = argv[i + 1];
-            ++i;
-        }
-        else if (arg == "--profile" && i + 1 < argc)
-        {
-            profilePath = argv[i + 1];
-            ++i;
-        }
-        else if (arg == "--save" || arg == "-s")
-        {
-            shouldSaveData = true;
-        }
-        else if (arg == "--uninstall" || arg == "-u")
-        {
-            shouldUninstall = true;
-        }
-        else if (arg == "--no-boot")
-        {
-            reinstallBoot = false;
-        }
-        else if (arg == "--update")
-        {
-            showExitScreen = false;
-        }
-    }
+    // Worked out off the frame loop (it may wait on range requests); needsAdmin stays -1 until it is in.
+    std::optional<Deferred<PreflightPlan>> preflightPlan;
+    bool browserNeedsHelper = false;
+    std::string installError;
+    bool installChecked = false;
+    bool browserCurrent = false;
+    bool profileCurrent = false;
+    std::string deltaBase;
+    bool deltaFailed = false;
+    auto installBegin = high_resolution_clock::now();
+    auto stepBegin = installBegin;
+    int startedStep = -1;
+    bool installReported = false;
+    // Whether the install got as far as downloading; prefetched archives nobody used are removed on exit.
+    bool archivesUsed = false;
 
     if (!browserPathStr.empty() && !profilePath.empty())
     {
@@ -857,12 +895,54 @@ int main(int argc, char* argv[])
 
     while (!glfwWindowShouldClose(window))
     {
+        frameProfileBeginFrame();
         glfwPollEvents();
 
+        // Fonts can't be added while a frame is being built, and the atlas belongs to
+        // this thread, so the body fonts are rasterised between the first two frames,
+        // while START is still fading in. Pages other than START need them up front.
+        if (!mediumFont && (framesDrawn > 0 || state != State::START))
+        {
+            TraceSpan span("body fonts", "startup");
+            mediumFont = io.Fonts->AddFontFromMemoryTTF(
+                CascadiaCode_Regular_ttf,
+                CascadiaCode_Regular_ttf_len,
+                22.0f * uiScale,
+                &cfg
+            );
+
+            bodyFont = io.Fonts->AddFontFromMemoryTTF(
+                CascadiaCode_Regular_ttf,
+                CascadiaCode_Regular_ttf_len,
+                18.0f * uiScale,
+                &cfg
+            );
+
+            lightFont = io.Fonts->AddFontFromMemoryTTF(
+                CascadiaCode_Light_ttf,
+                CascadiaCode_Light_ttf_len,
+                14.0f * uiScale,
+                &cfg
+            );
+
+            // The first font added is the default one, which would otherwise be the title font now.
+            io.FontDefault = mediumFont;
+
+#if IMGUI_VERSION_NUM < 19200
+            // Before 1.92 the backend only uploads the atlas when it recreates its device objects.
+            ImGui_ImplOpenGL3_DestroyDeviceObjects();
+#endif
+        }
+
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
 
+        if (ImGui::IsKeyPressed(ImGuiKey_F12, false))
+        {
+            frameProfileToggle();
+        }
+
         ImGuiStyle& style = ImGui::GetStyle();
         style.Colors[ImGuiCol_Separator] = ImVec4(0.8f, 0.8f, 0.8f, 1.0f);
 
@@ -878,6 +958,10 @@ int main(int argc, char* argv[])
         auto end = high_resolution_clock::now();
         float timeDiff = duration_cast<std::chrono::milliseconds>(end - begin).count();
 
+        // Pages may move on mid-frame; the time goes to the one that started it.
+        const State pageState = state;
+        const auto pageBegin = steady_clock::now();
+
         if (state == State::START)
         {
             const char* transitionHeader = "your gateway to the internet:";
@@ -925,7 +1009,7 @@ int main(int argc, char* argv[])
             bool hasError = false;
             
             renderStepHeader("Confirm your browser location", mediumFont, timeDiff);
-            const std::string autoBrowserPath = getBrowserLocation(selectedBrowser, selectedVersion);
+            const std::string& autoBrowserPath = locations.get().installs[selectedBrowser][selectedVersion];
             if (browserPath[0] == '\0')
             {
                 memset(browserPath, 0, sizeof(browserPath));
@@ -967,7 +1051,7 @@ int main(int argc, char* argv[])
             ImGui::Dummy(ImVec2(0.0f, 20.0f));
 
             renderStepHeader("Confirm your profile location", mediumFont, timeDiff);
-            const std::string autoProfilePath = getProfileLocation(selectedBrowser);
+            const std::string& autoProfilePath = locations.get().profiles[selectedBrowser];
             if (profileFolderPath[0] == '\0')
             {
                 memset(profileFolderPath, 0, sizeof(profileFolderPath));
@@ -1014,29 +1098,7 @@ int main(int argc, char* argv[])
 
             renderStepHeader("Choose your profile", mediumFont, timeDiff);
 
-            std::vector<std::string> profiles;
-            for (const auto& entry : std::filesystem::directory_iterator(profileFolderPath))
-            {
-                if (std::filesystem::is_directory(entry.status()))
-                {
-                    std::string dirName = entry.path().filename().string();
-
-                    if (showHiddenProfiles)
-                    {
-                        profiles.push_back(dirName);
-                        continue;
-                    }
-
-                    for (const auto& subEntry : std::filesystem::directory_iterator(entry.path()))
-                    {
-                        if (subEntry.path().filename() == "prefs.js")
-                        {
-                            profiles.push_back(dirName);
-                            break;
-                        }
-                    }
-                }
-            }
+            std::vector<std::string> profiles = listProfiles(profileFolderPath, showHiddenProfiles);
 
             renderOptions(profiles, selectedProfile, bodyFont);
 
@@ -1120,6 +1182,23 @@ int main(int argc, char* argv[])
                 std::filesystem::create_directory(std::filesystem::path(profilePath) / "chrome");
             }
 
+            // Decided once: what is already at the current version is left alone.
+            if (!installChecked)
+            {
+                installChecked = true;
+                if (!forceInstall && !shouldUninstall)
+                {
+                    browserCurrent = reinstallBoot && browserUpToDate(browserPathStr);
+                    profileCurrent = profileUpToDate(profilePath);
+                    if (!profileCurrent && !offline)
+                    {
+                        deltaBase = deltaBaseVersion(profilePath);
+                    }
+                }
+            }
+            const bool installBrowser = reinstallBoot && !browserCurrent;
+            const bool upToDate = !shouldUninstall && !installBrowser && profileCurrent;
+
             std::vector<char*> steps;
             if (shouldUninstall)
             {
@@ -1132,36 +1211,116 @@ int main(int argc, char* argv[])
             }
             else
             {
-                if (reinstallBoot)
+                // Offline builds carry the archives in the executable itself.
+                if (installBrowser)
                 {
+                    if (!offline)
+                    {
+                        steps.insert(steps.end(), { "Downloading program.zip..." });
+                    }
+                    steps.insert(steps.end(), { "Configuring your browser..." });
+                }
+
+                if (!profileCurrent)
+                {
+                    // A failed delta update is replaced in place by the full steps, starting at the same index.
+                    if (!deltaBase.empty() && !deltaFailed)
+                    {
+                        steps.insert(steps.end(), { "Updating your profile..." });
+                    }
+                    else
+                    {
+                        if (!offline)
+                        {
+                            steps.insert(steps.end(), {
+                                "Downloading profile.zip...",
+                                "Downloading engine.zip...",
+                                "Downloading locales.zip..."
+                            });
+                        }
+
+                        // Extracted beside the live files and swapped in, so nothing needs cleaning first.
+                        steps.insert(steps.end(), { "Configuring your profile..." });
+                    }
+
                     steps.insert(steps.end(), {
-                        "Downloading program.zip...",
-                        "Configuring your browser..."
+                        "Removing mods...",
+                        "Clearing startup cache..."
                     });
                 }
 
-                steps.insert(steps.end(), {
-                    "Downloading profile.zip...",
-                    "Downloading engine.zip...",
-                    "Downloading locales.zip...",
-                    "Cleaning up your profile...",
-                    "Configuring your profile...",
-                    "Removing mods...",
-                    "Clearing startup cache...",
-                    "Cleaning up...",
-                });
+                if (!upToDate)
+                {
+                    steps.insert(steps.end(), { "Cleaning up..." });
+                }
+            }
+            if (upToDate)
+            {
+                steps.insert(steps.end(), { "Sine is already up to date." });
+            }
+            else
+            {
+                steps.insert(steps.end(), { "Finished." });
             }
-            steps.insert(steps.end(), { "Finished." });
 
-            if (needsAdmin == -1)
+            if (needsAdmin == -1 && !preflightPlan)
             {
-                needsAdmin = ((reinstallBoot || shouldUninstall) && !canWriteToFolder(browserPathStr)) || !canWriteToFolder(profilePath) ? 1 : 0;
+                // Space and permissions are settled here, before the first download.
+                PreflightOptions preflight;
+                preflight.browserPath = installBrowser || shouldUninstall ? browserPathStr : "";
+                preflight.profilePath = profilePath;
+                preflight.installBrowser = installBrowser;
+                preflight.installProfile = !profileCurrent && !shouldUninstall;
+                preflight.downloadsFolder = downloads.get();
+                preflight.offline = offline;
+                if (installBrowser && !isAdmin.get())
+                {
+                    std::error_code ec;
+                    preflight.stagingFolder = std::filesystem::temp_directory_path(ec).string();
+                }
+                const bool skip = upToDate;
+                preflightPlan.emplace([=]() { return skip ? PreflightPlan() : planInstall(preflight); });
+            }
+
+            if (needsAdmin == -1 && preflightPlan->ready())
+            {
+                // A protected browser folder is handed to the elevated helper, so downloads and
+                // extraction stay in this process. Only an unwritable profile needs a full relaunch.
+                const PreflightPlan& plan = preflightPlan->get();
+
+                browserNeedsHelper = !isAdmin.get() && (installBrowser || shouldUninstall) && !plan.browserWritable;
+                needsAdmin = plan.profileWritable ? 0 : 1;
+                if (!plan.problems.empty())
+                {
+                    installError = plan.problems.front();
+                    for (const std::string& problem : plan.problems)
+                    {
+                        std::cerr << problem << "\n";
+                        progressError("preflight", 0, problem);
+                    }
+                }
+                for (const std::string& archive : plan.unsized)
+                {
+                    std::cerr << "Could not size " << archive << " ahead of the install.\n";
+                }
             }
 
-            bool hasPerms = isAdmin || !needsAdmin;
-            bool browserOpen = isProcessRunning(toLowercase(browsers[selectedBrowser].first) + (getOS() == "win32" ? ".exe" : ""));
+            // Nothing gets written when everything is current, so neither privileges nor a closed browser are needed.
+            bool hasPerms = isAdmin.get() || !needsAdmin || upToDate;
+            bool browserOpen = !upToDate && isProcessRunning(toLowercase(browsers[selectedBrowser].first) + (getOS() == "win32" ? ".exe" : ""));
 
-            if (hasPerms && (!browserOpen || !showExitScreen))
+            if (needsAdmin == -1)
+            {
+                renderStepHeader("Checking your install...", mediumFont, timeDiff);
+            }
+            else if (!installError.empty())
+            {
+                renderStepHeader("Installation failed.", mediumFont, timeDiff);
+                ImGui::PushFont(lightFont);
+                ImGui::Text("%s", installError.c_str());
+                ImGui::PopFont();
+            }
+            else if (hasPerms && (!browserOpen || !showExitScreen))
             {
                 renderStepHeader(steps[installStep], mediumFont, timeDiff);
                 const float totalWidth = ImGui::GetContentRegionAvail().x;
@@ -1171,80 +1330,121 @@ int main(int argc, char* argv[])
                 ImGui::PopStyleColor();
                 ImGui::PopStyleColor();
 
-                if (strstr(steps[installStep], "program.zip") != nullptr)
+                // The last step only shows the result and is drawn every frame until the window closes.
+                const bool finalStep = installStep == steps.size() - 1;
+                // A step waiting on the prefetcher runs again on the next frame.
+                if (startedStep != installStep)
                 {
-                    const std::string fileName = "/program.zip";
-                    downloadFile(bootloaderReleases + bootVersion + fileName, downloadsFolder + fileName);
-                }
-                else if (strstr(steps[installStep], "Configuring your browser") != nullptr)
-                {
-                    extractZip(downloadsFolder + "/program.zip", browserPathStr);
+                    startedStep = installStep;
+                    stepBegin = high_resolution_clock::now();
+                    if (installStep == 0)
+                    {
+                        installBegin = stepBegin;
+                    }
+                    if (!finalStep)
+                    {
+                        progressStepStart(installStep, steps.size(), steps[installStep]);
+                    }
                 }
-                else if (strstr(steps[installStep], "profile.zip") != nullptr)
+                TraceSpan stepSpan(finalStep ? nullptr : steps[installStep], "install");
+
+                // Startup work still running in the background joins here; it has long finished by now.
+                prefetching.get();
+                const std::string& downloadsFolder = downloads.get();
+
+                bool stepPending = false;
+
+                if (strncmp(steps[installStep], "Downloading ", 12) == 0)
                 {
-                    const std::string fileName = "/profile.zip";
-                    downloadFile(bootloaderReleases + bootVersion + fileName, downloadsFolder + fileName);
+                    // "Downloading profile.zip..." -> "profile.zip"
+                    const std::string archive(steps[installStep] + 12, strlen(steps[installStep]) - 15);
+                    archivesUsed = true;
+                    switch (fetchArchive(downloadsFolder, archive))
+                    {
+                    case FetchResult::PENDING:
+                        stepPending = true;
+                        break;
+                    case FetchResult::FAILED:
+                        installError = "Failed to download or verify " + archive + ".";
+                        break;
+                    default:
+                        break;
+                    }
                 }
-                else if (strstr(steps[installStep], "engine.zip") != nullptr)
+                else if (strstr(steps[installStep], "Configuring your browser") != nullptr)
                 {
-                    const std::string fileName = "/engine.zip";
-                    downloadFile(sineReleases + sineVersion + fileName, downloadsFolder + fileName);
+                    if (browserNeedsHelper)
+                    {
+                        if (!installBrowserViaHelper(downloadsFolder, browserPathStr, profilePath))
+                        {
+                            installError = "Failed to configure your browser with elevated privileges.";
+                        }
+                    }
+                    else if (!extractArchive(downloadsFolder, "program.zip", browserPathStr))
+                    {
+                        installError = "Failed to extract program.zip.";
+                    }
+                    else
+                    {
+                        writeBrowserStamp(browserPathStr);
+                    }
                 }
-                else if (strstr(steps[installStep], "locales.zip") != nullptr)
+                else if (strstr(steps[installStep], "Configuring your profile") != nullptr)
                 {
-                    const std::string fileName = "/locales.zip";
-                    downloadFile(sineReleases + sineVersion + fileName, downloadsFolder + fileName);
+                    configureProfile(downloadsFolder, profilePath, installError);
                 }
-                else if (strstr(steps[installStep], "Configuring your profile") != nullptr)
+                else if (strstr(steps[installStep], "Updating your profile") != nullptr)
                 {
-                    extractZip(downloadsFolder + "/profile.zip", profilePath + "/chrome");
-                    extractZip(downloadsFolder + "/engine.zip", profilePath + "/chrome");
-                    extractZip(downloadsFolder + "/locales.zip", profilePath + "/chrome");
-
-                    std::ofstream file(profilePath + "/prefs.js", std::ios::app);
-                    file <<
-                        ("user_pref(\"sine.is-cosine\", " + std::string(isCosine ? "true" : "false") + ");") << std::endl <<
-                        ("user_pref(\"sine.version\", \"" + sineVersion + "\");") << std::endl <<
-                        ("user_pref(\"sine.latest-version\", \"" + sineVersion + "\");") << std::endl;
-                    file.close();
+                    if (!updateProfileFromDelta(downloadsFolder, profilePath, deltaBase))
+                    {
+                        progressStepEnd(installStep, steps.size(), steps[installStep], false,
+                            duration<double, std::milli>(high_resolution_clock::now() - stepBegin).count());
+                        deltaFailed = true;
+                        startedStep = -1;
+                        stepPending = true;
+                    }
                 }
                 else if (strstr(steps[installStep], "Cleaning up your browser") != nullptr)
                 {
-                    std::filesystem::remove(browserPathStr + "/defaults/pref/config-prefs.js");
-                    std::filesystem::remove(browserPathStr + "config.js");
+                    const std::string configPrefs = (std::filesystem::path(browserPathStr) / "defaults" / "pref" / "config-prefs.js").string();
+                    const std::string configJs = (std::filesystem::path(browserPathStr) / "config.js").string();
+                    const std::string browserStamp = (std::filesystem::path(browserPathStr) / ".sine-version").string();
+
+                    if (browserNeedsHelper)
+                    {
+                        std::vector<HelperOp> ops = {
+                            { HelperOp::Kind::REMOVE, "", configPrefs },
+                            { HelperOp::Kind::REMOVE, "", configJs },
+                            { HelperOp::Kind::REMOVE, "", browserStamp }
+                        };
+                        if (!runPrivilegedHelper(browserPathStr, profilePath, ops))
+                        {
+                            installError = "Failed to clean up your browser with elevated privileges.";
+                        }
+                    }
+                    else
+                    {
+                        TraceSpan span("remove", "fs", configJs);
+                        std::filesystem::remove(configPrefs);
+                        std::filesystem::remove(configJs);
+                        std::filesystem::remove(browserStamp);
+                    }
                 }
                 else if (strstr(steps[installStep], "Cleaning up your profile") != nullptr)
                 {
-                    removeDir(profilePath + "/chrome/JS");
-                    removeDir(profilePath + "/chrome/utils");
-                    removeDir(profilePath + "/chrome/locales");
+                    cleanProfile(profilePath);
                 }
-                else if (
-                    !shouldSaveData && strstr(steps[installStep], "Removing mods") != nullptr &&
-                    std::filesystem::exists(std::filesystem::path(profilePath) / "chrome" / "sine-mods")
-                )
+                else if (!shouldSaveData && strstr(steps[installStep], "Removing mods") != nullptr)
                 {
-                    std::filesystem::remove_all(profilePath + "/chrome/sine-mods");
+                    removeMods(profilePath);
                 }
                 else if (strstr(steps[installStep], "Clearing startup cache") != nullptr)
                 {
-                    if (getOS() == "win32")
-                    {
-                        size_t pos = profilePath.find("Roaming");
-                        removeDir(profilePath.replace(pos, 7, "Local") + "/startupCache");
-                    }
-                    else if (getOS() == "darwin")
-                    {
-                        size_t pos = profilePath.find("Application Support");
-                        removeDir(profilePath.replace(pos, 19, "Caches") + "/startupCache");
-                    }
+                    clearStartupCache(profilePath);
                 }
                 else if (strstr(steps[installStep], "Cleaning up") != nullptr)
                 {
-                    std::filesystem::remove(downloadsFolder + "/program.zip");
-                    std::filesystem::remove(downloadsFolder + "/profile.zip");
-                    std::filesystem::remove(downloadsFolder + "/engine.zip");
-                    std::filesystem::remove(downloadsFolder + "/locales.zip");
+                    pruneArchives(downloadsFolder);
                 }
                 else
                 {
@@ -1255,7 +1455,25 @@ int main(int argc, char* argv[])
                     ImGui::PopFont();
                 }
 
-                if (installStep != steps.size() - 1)
+                if (!finalStep && !stepPending)
+                {
+                    progressStepEnd(installStep, steps.size(), steps[installStep], installError.empty(),
+                        duration<double, std::milli>(high_resolution_clock::now() - stepBegin).count());
+                    if (!installError.empty())
+                    {
+                        progressError("install", 0, installError);
+                    }
+                }
+                if ((finalStep || !installError.empty()) && !installReported)
+                {
+                    const TransferStats transfers = getTransferStats();
+                    progressDone(installError.empty(),
+                        duration<double, std::milli>(high_resolution_clock::now() - installBegin).count(),
+                        transfers.transfers, transfers.bytesReceived);
+                    installReported = true;
+                }
+
+                if (installError.empty() && !stepPending && installStep != steps.size() - 1)
                 {
                     installStep += 1;
                 }
@@ -1322,17 +1540,55 @@ int main(int argc, char* argv[])
             glfwSetWindowShouldClose(window, GLFW_TRUE);
         }
 
+        frameProfileSection(stateNames[static_cast<int>(pageState)],
+            duration<double, std::milli>(steady_clock::now() - pageBegin).count());
+
         ImGui::End();
 
+        frameProfileDraw();
+
         ImGui::Render();
+        frameProfileGpuBegin();
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        frameProfileGpuEnd();
+        frameProfileEndFrame(ImGui::GetDrawData());
         glfwSwapBuffers(window);
+
+        if (framesDrawn++ == 0)
+        {
+            const double ms = duration<double, std::milli>(steady_clock::now() - launched).count();
+            traceEvent("first frame", "startup", 0, traceNow());
+            progressFirstFrame(ms, firstFrameBudgetMs);
+            if (ms > firstFrameBudgetMs)
+            {
+                std::cerr << "First frame after " << static_cast<int>(ms) << " ms, over the "
+                    << static_cast<int>(firstFrameBudgetMs) << " ms budget.\n";
+            }
+        }
     }
 
+    frameProfileShutdown();
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
     glfwDestroyWindow(window);
     glfwTerminate();
+
+    // Background work still running would outlive the transfer pool and the trace
+    // ring, which go below; the preflight plan may be mid-fetchTail().
+    prefetching.get();
+    isAdmin.wait();
+    locations.wait();
+    if (preflightPlan)
+    {
+        preflightPlan->wait();
+    }
+    prefetchCancel(!archivesUsed);
+    closePayload();
+    netCleanup();
+    traceClose();
+    progressClose();
+
+    return installError.empty() ? 0 : 1;
 }
@@ -0,0 +1,119 @@
+#include <mirrors.h>
+#include <trace.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+    const std::string githubOrigin = "https://github.com";
+
+    std::vector<std::string> mirrors;
+
+    // How long a probe may take before its mirror counts as unhealthy.
+    constexpr long probeTimeoutMs = 3000;
+    // A mirror slower than this for stallSeconds is dropped for the next candidate.
+    constexpr int64_t failoverBytesPerSecond = 16 << 10;
+}
+
+void addMirror(std::string origin)
+{
+    while (!origin.empty() && origin.back() == '/')
+    {
+        origin.pop_back();
+    }
+    if (!origin.empty() && origin != githubOrigin)
+    {
+        mirrors.push_back(origin);
+    }
+}
+
+void addMirrorsFromEnvironment()
+{
+    const char* value = std::getenv("SINE_MIRRORS");
+    if (!value) return;
+
+    std::stringstream list(value);
+    for (std::string origin; std::getline(list, origin, ',');)
+    {
+        addMirror(origin);
+    }
+}
+
+std::vector<std::string> mirrorCandidates(const std::string& url)
+{
+    std::vector<std::string> candidates;
+    if (url.compare(0, githubOrigin.size() + 1, githubOrigin + "/") == 0)
+    {
+        for (const std::string& origin : mirrors)
+        {
+            candidates.push_back(origin + url.substr(githubOrigin.size()));
+        }
+    }
+    candidates.push_back(url);
+    return candidates;
+}
+
+std::vector<std::string> rankCandidates(const std::vector<std::string>& candidates)
+{
+    TraceSpan span("rank mirrors", "net");
+    const std::vector<int64_t> latencies = raceProbes(candidates, probeTimeoutMs);
+
+    std::vector<size_t> order(candidates.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    // Untimed candidates (-1) sort after the timed ones and keep their given order.
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if ((latencies[a] < 0) != (latencies[b] < 0)) return latencies[b] < 0;
+        return latencies[a] >= 0 && latencies[a] < latencies[b];
+    });
+
+    std::vector<std::string> ranked;
+    for (size_t i : order)
+    {
+        ranked.push_back(candidates[i]);
+    }
+    return ranked;
+}
+
+bool downloadFromCandidates(const std::vector<std::string>& candidates, const std::string& outputPath,
+    const std::string& expectedSha256, DownloadControl* control)
+{
+    if (candidates.size() == 1)
+    {
+        return downloadFile(candidates.front(), outputPath, expectedSha256, control);
+    }
+
+    const std::vector<std::string> ranked = rankCandidates(candidates);
+    for (size_t i = 0; i < ranked.size(); ++i)
+    {
+        // The last candidate gets all the time it needs, as does a deliberately throttled one.
+        const bool last = i + 1 == ranked.size();
+        const bool throttled = control && control->maxBytesPerSecond > 0;
+        if (downloadFile(ranked[i], outputPath, expectedSha256, control,
+            last || throttled ? 0 : failoverBytesPerSecond))
+        {
+            return true;
+        }
+        if (control && control->cancel)
+        {
+            return false;
+        }
+        if (!last)
+        {
+            std::cerr << "Failing over to " << ranked[i + 1] << ".\n";
+        }
+    }
+    return false;
+}
+
+bool downloadMirrored(const std::string& url, const std::string& outputPath,
+    const std::string& expectedSha256, DownloadControl* control)
+{
+    return downloadFromCandidates(mirrorCandidates(url), outputPath, expectedSha256, control);
+}
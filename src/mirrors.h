@@ -0,0 +1,32 @@
+#pragma once
+
+#include <net.h>
+
+#include <string>
+#include <vector>
+
+// Release archives can also come from mirrors of github.com, such as an internal
+// proxy or cache. A mirror origin takes the place of "https://github.com" in a
+// release URL and keeps the rest of the path. Mirrors come from --mirror (in the
+// order given) followed by the SINE_MIRRORS environment variable (comma
+// separated); github.com itself is always the last candidate.
+void addMirror(std::string origin);
+void addMirrorsFromEnvironment();
+
+// Every URL url can be fetched from, in configured order. Just url without mirrors
+// or when it is not a github.com URL.
+std::vector<std::string> mirrorCandidates(const std::string& url);
+
+// Races a probe against every candidate. The candidate that answered first leads,
+// the rest follow in their given order; unhealthy ones only as a last resort.
+std::vector<std::string> rankCandidates(const std::vector<std::string>& candidates);
+
+// Downloads from the ranked candidates, failing over to the next one when a
+// transfer fails, stalls or delivers a file that does not match expectedSha256.
+// A single candidate is downloaded directly, without probing.
+bool downloadFromCandidates(const std::vector<std::string>& candidates, const std::string& outputPath,
+    const std::string& expectedSha256 = "", DownloadControl* control = nullptr);
+
+// downloadFromCandidates(mirrorCandidates(url), ...).
+bool downloadMirrored(const std::string& url, const std::string& outputPath,
+    const std::string& expectedSha256 = "", DownloadControl* control = nullptr);
@@ -0,0 +1,706 @@
+#include <net.h>
+#include <platform.h>
+#include <progress.h>
+#include <sha256.h>
+#include <throttle.h>
+#include <trace.h>
+
+#define NOMINMAX
+#include <curl/curl.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    CURLSH* share = nullptr;
+    std::mutex shareLocks[CURL_LOCK_DATA_LAST];
+
+    std::mutex poolMutex;
+    std::vector<CURL*> handlePool;
+
+    std::mutex statsMutex;
+    TransferStats stats;
+
+    // Shared by every transfer, so concurrent downloads split the ceiling between them.
+    TokenBucket network;
+
+    void lockShare(CURL*, curl_lock_data data, curl_lock_access, void*)
+    {
+        shareLocks[data].lock();
+    }
+
+    void unlockShare(CURL*, curl_lock_data data, void*)
+    {
+        shareLocks[data].unlock();
+    }
+
+    CURL* acquireHandle()
+    {
+        CURL* curl = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(poolMutex);
+            if (!handlePool.empty())
+            {
+                curl = handlePool.back();
+                handlePool.pop_back();
+            }
+        }
+
+        if (!curl)
+        {
+            curl = curl_easy_init();
+            if (!curl) return nullptr;
+        }
+        else
+        {
+            // Keeps the handle's own connection and session caches alive.
+            curl_easy_reset(curl);
+        }
+
+        if (share)
+        {
+            curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        }
+
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (long)CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_DNS_CACHE_TIMEOUT, 600L);
+        curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+
+        return curl;
+    }
+
+    void releaseHandle(CURL* curl)
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        handlePool.push_back(curl);
+    }
+
+    void recordTransfer(CURL* curl, CURLcode res)
+    {
+        long connects = 0;
+        curl_off_t bytes = 0;
+        curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.transfers += 1;
+        if (res != CURLE_OK)
+        {
+            stats.failedTransfers += 1;
+        }
+
+        // CURLINFO_NUM_CONNECTS counts connections this transfer had to open,
+        // including redirect hops; zero means everything came from the pool.
+        if (connects > 0)
+        {
+            stats.newConnections += connects;
+        }
+        else
+        {
+            stats.reusedConnections += 1;
+        }
+        stats.bytesReceived += bytes;
+    }
+
+    // Splits a finished transfer into curl's phases. The *_TIME_T values are
+    // cumulative microseconds from the start of the transfer.
+    void tracePhases(CURL* curl, int64_t started, const std::string& url)
+    {
+        curl_off_t dns = 0, connect = 0, tls = 0, firstByte = 0, total = 0;
+        curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+        curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+        curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+        curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByte);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+
+        // A reused connection reports zero for the phases it skipped.
+        const curl_off_t connected = tls > 0 ? tls : connect;
+
+        traceEvent("download", "net", started, total, url.c_str());
+        if (dns > 0) traceEvent("dns", "net", started, dns);
+        if (connect > dns) traceEvent("connect", "net", started + dns, connect - dns);
+        if (tls > connect) traceEvent("tls", "net", started + connect, tls - connect);
+        if (firstByte > connected) traceEvent("first byte", "net", started + connected, firstByte - connected);
+        if (total > firstByte) traceEvent("body", "net", started + firstByte, total - firstByte);
+    }
+}
+
+bool netInit()
+{
+    if (curl_global_init(CURL_GLOBAL_DEFAULT) != CURLE_OK)
+    {
+        std::cerr << "Failed to initialise libcurl.\n";
+        return false;
+    }
+
+    share = curl_share_init();
+    if (share)
+    {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+
+    return true;
+}
+
+void netCleanup()
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        for (CURL* curl : handlePool)
+        {
+            curl_easy_cleanup(curl);
+        }
+        handlePool.clear();
+    }
+
+    if (share)
+    {
+        curl_share_cleanup(share);
+        share = nullptr;
+    }
+
+    // Connection reuse is a diagnostic; normal runs report transfers in their "done" event.
+    const TransferStats s = getTransferStats();
+    if (s.transfers > 0 && traceEnabled())
+    {
+        std::cerr << "Transfers: " << s.transfers
+            << ", new connections: " << s.newConnections
+            << ", reused: " << s.reusedConnections
+            << ", not modified: " << s.notModified
+            << ", bytes: " << s.bytesReceived << "\n";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats = TransferStats();
+    }
+
+    curl_global_cleanup();
+}
+
+namespace
+{
+    // The validators a server sent with a file, stored next to it as "<file>.validators".
+    // They only apply to requests for the same url.
+    struct Validators
+    {
+        std::string url;
+        std::string etag;
+        std::string lastModified;
+    };
+
+    std::string validatorsPath(const std::string& outputPath)
+    {
+        return outputPath + ".validators";
+    }
+
+    Validators readValidators(const std::string& outputPath)
+    {
+        Validators validators;
+        std::ifstream file(validatorsPath(outputPath), std::ios::binary);
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.rfind("url ", 0) == 0) validators.url = line.substr(4);
+            else if (line.rfind("etag ", 0) == 0) validators.etag = line.substr(5);
+            else if (line.rfind("last-modified ", 0) == 0) validators.lastModified = line.substr(14);
+        }
+        return validators;
+    }
+
+    void writeValidators(const std::string& outputPath, const Validators& validators)
+    {
+        std::error_code ec;
+        if (validators.etag.empty() && validators.lastModified.empty())
+        {
+            std::filesystem::remove(validatorsPath(outputPath), ec);
+            return;
+        }
+
+        std::ofstream file(validatorsPath(outputPath), std::ios::binary | std::ios::trunc);
+        file << "url " << validators.url << "\n";
+        if (!validators.etag.empty()) file << "etag " << validators.etag << "\n";
+        if (!validators.lastModified.empty()) file << "last-modified " << validators.lastModified << "\n";
+    }
+
+    // Keeps the validators of the last response; a redirect's own headers come first and are dropped.
+    size_t collectValidator(char* buffer, size_t size, size_t nitems, void* userdata)
+    {
+        Validators* validators = static_cast<Validators*>(userdata);
+        std::string line(buffer, size * nitems);
+        while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+        {
+            line.pop_back();
+        }
+
+        if (line.rfind("HTTP/", 0) == 0)
+        {
+            validators->etag.clear();
+            validators->lastModified.clear();
+            return size * nitems;
+        }
+
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) return size * nitems;
+
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        const size_t start = line.find_first_not_of(' ', colon + 1);
+        const std::string value = start == std::string::npos ? "" : line.substr(start);
+
+        if (name == "etag") validators->etag = value;
+        else if (name == "last-modified") validators->lastModified = value;
+        return size * nitems;
+    }
+
+    // Whether a local copy still has the content expectedSha256 pins.
+    bool fileMatches(const std::string& path, const std::string& expectedSha256)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        Sha256 hash;
+        std::vector<char> chunk(1 << 18);
+        while (file.read(chunk.data(), chunk.size()) || file.gcount() > 0)
+        {
+            hash.update(chunk.data(), static_cast<size_t>(file.gcount()));
+        }
+        return hash.finishHex() == expectedSha256;
+    }
+}
+
+struct DownloadSink
+{
+    std::ofstream file;
+    Sha256 hash;
+    std::string url;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point lastReport;
+    DownloadControl* control = nullptr;
+    uint64_t received = 0;
+};
+
+// Sleeps until the bytes received so far fit under the ceiling. Waits in short
+// slices so a lifted ceiling or a cancel takes effect promptly.
+void throttle(DownloadSink* sink)
+{
+    while (!sink->control->cancel)
+    {
+        const int64_t limit = sink->control->maxBytesPerSecond;
+        if (limit <= 0) return;
+
+        const auto due = sink->started + std::chrono::microseconds(sink->received * 1000000 / static_cast<uint64_t>(limit));
+        const auto now = std::chrono::steady_clock::now();
+        if (due <= now) return;
+
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(due - now, std::chrono::milliseconds(50)));
+    }
+}
+
+size_t writeData(void* ptr, size_t size, size_t nmemb, void* stream)
+{
+    DownloadSink* out = static_cast<DownloadSink*>(stream);
+    out->file.write(static_cast<char*>(ptr), size * nmemb);
+    // Anything short of the full count makes curl stop with CURLE_WRITE_ERROR.
+    if (!out->file) return 0;
+
+    // Hashing here overlaps with the network wait instead of re-reading the file later.
+    out->hash.update(ptr, size * nmemb);
+    network.take(size * nmemb);
+
+    if (out->control)
+    {
+        out->received += size * nmemb;
+        throttle(out);
+    }
+    return size * nmemb;
+}
+
+// Only installed for a progress stream or a DownloadControl. Reports at most four
+// times a second; a non-zero return makes curl abort the transfer.
+int reportProgress(void* clientp, curl_off_t total, curl_off_t now, curl_off_t, curl_off_t)
+{
+    DownloadSink* sink = static_cast<DownloadSink*>(clientp);
+    if (sink->control && sink->control->cancel) return 1;
+    if (!progressEnabled()) return 0;
+
+    const auto time = std::chrono::steady_clock::now();
+    if (now == 0 || time - sink->lastReport < std::chrono::milliseconds(250)) return 0;
+
+    sink->lastReport = time;
+    const double seconds = std::chrono::duration<double>(time - sink->started).count();
+    progressTransfer(sink->url, static_cast<uint64_t>(now), static_cast<uint64_t>(total),
+        seconds > 0.0 ? now / seconds : 0.0);
+    return 0;
+}
+
+std::string downloadedFrom(const std::string& outputPath)
+{
+    return readValidators(outputPath).url;
+}
+
+bool downloadFile(const std::string& url, const std::string& outputPath, const std::string& expectedSha256,
+    DownloadControl* control, int64_t minBytesPerSecond)
+{
+    // A copy from an earlier run is only fetched again when the server says it changed.
+    std::error_code ec;
+    const Validators stored = std::filesystem::exists(outputPath, ec) ? readValidators(outputPath) : Validators();
+    const bool revalidate = stored.url == url && (!stored.etag.empty() || !stored.lastModified.empty());
+
+    CURL* curl = acquireHandle();
+    if (!curl) return false;
+
+    // The body goes to a side file, so a failed or unneeded transfer leaves an existing copy alone.
+    const std::string partPath = outputPath + ".part";
+    DownloadSink sink;
+    sink.file.open(partPath, std::ios::binary);
+    if (!sink.file.is_open())
+    {
+        releaseHandle(curl);
+        return false;
+    }
+
+    Validators received;
+    received.url = url;
+    curl_slist* conditions = nullptr;
+    if (revalidate)
+    {
+        if (!stored.etag.empty()) conditions = curl_slist_append(conditions, ("If-None-Match: " + stored.etag).c_str());
+        if (!stored.lastModified.empty()) conditions = curl_slist_append(conditions, ("If-Modified-Since: " + stored.lastModified).c_str());
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeData);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, collectValidator);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &received);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, conditions);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    if (minBytesPerSecond > 0)
+    {
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, static_cast<long>(minBytesPerSecond));
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, stallSeconds);
+    }
+    if (network.rate() > 0)
+    {
+        // Lets curl pace its socket reads too, instead of letting the receive window fill up in bursts.
+        curl_easy_setopt(curl, CURLOPT_MAX_RECV_SPEED_LARGE, static_cast<curl_off_t>(network.rate()));
+    }
+
+    if (progressEnabled() || control)
+    {
+        sink.url = url;
+        sink.control = control;
+        sink.started = sink.lastReport = std::chrono::steady_clock::now();
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, reportProgress);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &sink);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    }
+
+    const int64_t started = traceNow();
+    CURLcode res = curl_easy_perform(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    recordTransfer(curl, res);
+    if (traceEnabled())
+    {
+        tracePhases(curl, started, url);
+    }
+    if (res == CURLE_OK && progressEnabled())
+    {
+        curl_off_t bytes = 0, speed = 0;
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bytes);
+        curl_easy_getinfo(curl, CURLINFO_SPEED_DOWNLOAD_T, &speed);
+        progressTransfer(url, static_cast<uint64_t>(bytes), static_cast<uint64_t>(bytes), static_cast<double>(speed));
+    }
+    releaseHandle(curl);
+    curl_slist_free_all(conditions);
+    sink.file.close();
+
+    if (res != CURLE_OK && control && control->cancel)
+    {
+        std::remove(partPath.c_str());
+        return false;
+    }
+
+    if (res != CURLE_OK)
+    {
+        std::cerr << "Download of " << url << " failed: " << curl_easy_strerror(res) << "\n";
+        progressError("curl", res, url + ": " + curl_easy_strerror(res));
+        std::remove(partPath.c_str());
+        return false;
+    }
+
+    // The digest covers the bytes received, not the bytes written: a write that
+    // failed at close (a full disk, say) leaves a file it cannot vouch for.
+    if (!sink.file)
+    {
+        std::cerr << "Failed to write " << partPath << ".\n";
+        progressError("write", 0, partPath);
+        std::remove(partPath.c_str());
+        return false;
+    }
+
+    if (status == 304)
+    {
+        std::remove(partPath.c_str());
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            stats.notModified += 1;
+        }
+
+        // Unchanged on the server, but the local copy may still have been damaged since.
+        if (expectedSha256.empty() || fileMatches(outputPath, expectedSha256))
+        {
+            return true;
+        }
+        std::filesystem::remove(validatorsPath(outputPath), ec);
+        return downloadFile(url, outputPath, expectedSha256, control, minBytesPerSecond);
+    }
+
+    const std::string digest = sink.hash.finishHex();
+    if (expectedSha256.empty())
+    {
+        std::cerr << "No pinned digest for " << url << " (sha256 " << digest << ").\n";
+    }
+    else if (digest != expectedSha256)
+    {
+        std::cerr << "Digest mismatch for " << url << ": expected " << expectedSha256 << ", got " << digest << ".\n";
+        progressError("sha256", 0, url + ": expected " + expectedSha256 + ", got " + digest);
+        std::remove(partPath.c_str());
+        return false;
+    }
+
+    std::filesystem::rename(partPath, outputPath, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to save " << outputPath << ": " << ec.message() << ".\n";
+        std::remove(partPath.c_str());
+        return false;
+    }
+
+    fixFilePerms(outputPath);
+    writeValidators(outputPath, received);
+    return true;
+}
+
+namespace
+{
+    size_t discardData(void*, size_t size, size_t nmemb, void*)
+    {
+        return size * nmemb;
+    }
+}
+
+std::vector<int64_t> raceProbes(const std::vector<std::string>& urls, long timeoutMs)
+{
+    std::vector<int64_t> latencies(urls.size(), -1);
+    CURLM* multi = curl_multi_init();
+    if (!multi) return latencies;
+
+    std::vector<CURL*> probes(urls.size(), nullptr);
+    for (size_t i = 0; i < urls.size(); ++i)
+    {
+        CURL* curl = acquireHandle();
+        if (!curl) continue;
+
+        curl_easy_setopt(curl, CURLOPT_URL, urls[i].c_str());
+        curl_easy_setopt(curl, CURLOPT_RANGE, "0-0");
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, discardData);
+        curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, reinterpret_cast<char*>(i));
+        curl_multi_add_handle(multi, curl);
+        probes[i] = curl;
+    }
+
+    const int64_t started = traceNow();
+    bool answered = false;
+    int running = 1;
+    while (running > 0 && !answered)
+    {
+        curl_multi_perform(multi, &running);
+
+        int queued = 0;
+        while (CURLMsg* message = curl_multi_info_read(multi, &queued))
+        {
+            if (message->msg != CURLMSG_DONE) continue;
+
+            char* index = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &index);
+            const size_t i = reinterpret_cast<size_t>(index);
+            if (message->data.result == CURLE_OK)
+            {
+                curl_off_t total = 0;
+                curl_easy_getinfo(message->easy_handle, CURLINFO_TOTAL_TIME_T, &total);
+                latencies[i] = total;
+                answered = true;
+            }
+            traceEvent("probe", "net", started, traceNow() - started, urls[i].c_str());
+        }
+
+        if (running > 0 && !answered)
+        {
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+        }
+    }
+
+    for (CURL* curl : probes)
+    {
+        if (!curl) continue;
+        curl_multi_remove_handle(multi, curl);
+        releaseHandle(curl);
+    }
+    curl_multi_cleanup(multi);
+    return latencies;
+}
+
+namespace
+{
+    struct TailSink
+    {
+        std::vector<uint8_t>* data;
+        size_t limit;
+    };
+
+    size_t collectTail(void* ptr, size_t size, size_t nmemb, void* stream)
+    {
+        TailSink* sink = static_cast<TailSink*>(stream);
+        const size_t bytes = size * nmemb;
+        // A server that ignores the range sends the whole file; stop it instead.
+        if (sink->data->size() + bytes > sink->limit) return 0;
+
+        const uint8_t* data = static_cast<const uint8_t*>(ptr);
+        sink->data->insert(sink->data->end(), data, data + bytes);
+        return bytes;
+    }
+
+    // "Content-Range: bytes 1000-1999/2000" -> 2000, from the last response only.
+    size_t collectContentRange(char* buffer, size_t size, size_t nitems, void* userdata)
+    {
+        uint64_t* total = static_cast<uint64_t*>(userdata);
+        std::string line(buffer, size * nitems);
+        if (line.rfind("HTTP/", 0) == 0)
+        {
+            *total = 0;
+            return size * nitems;
+        }
+
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) return size * nitems;
+
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        const size_t slash = line.find('/', colon);
+        if (name == "content-range" && slash != std::string::npos)
+        {
+            *total = std::strtoull(line.c_str() + slash + 1, nullptr, 10);
+        }
+        return size * nitems;
+    }
+}
+
+bool fetchTail(const std::string& url, size_t tailBytes, std::vector<uint8_t>& tail, uint64_t& totalSize)
+{
+    tail.clear();
+    totalSize = 0;
+    CURL* curl = acquireHandle();
+    if (!curl) return false;
+
+    TailSink sink = { &tail, tailBytes };
+    const std::string range = "-" + std::to_string(tailBytes);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, collectTail);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, collectContentRange);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, &totalSize);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    // The wizard waits for the plan on exit; a stalled server must not hold it up for long.
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+
+    const int64_t started = traceNow();
+    CURLcode res = curl_easy_perform(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    recordTransfer(curl, res);
+    if (traceEnabled())
+    {
+        tracePhases(curl, started, url);
+    }
+    releaseHandle(curl);
+
+    return res == CURLE_OK && status == 206 && !tail.empty() && totalSize >= tail.size();
+}
+
+bool fetchDocument(const std::string& url, size_t maxBytes, std::string& body, const std::vector<std::string>& headers)
+{
+    body.clear();
+    if (url.rfind("https://", 0) != 0) return false;
+    CURL* curl = acquireHandle();
+    if (!curl) return false;
+
+    std::vector<uint8_t> data;
+    TailSink sink = { &data, maxBytes };
+    curl_slist* list = nullptr;
+    for (const std::string& header : headers)
+    {
+        list = curl_slist_append(list, header.c_str());
+    }
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+#if LIBCURL_VERSION_NUM >= 0x075500
+    curl_easy_setopt(curl, CURLOPT_PROTOCOLS_STR, "https");
+    curl_easy_setopt(curl, CURLOPT_REDIR_PROTOCOLS_STR, "https");
+#else
+    curl_easy_setopt(curl, CURLOPT_PROTOCOLS, (long)CURLPROTO_HTTPS);
+    curl_easy_setopt(curl, CURLOPT_REDIR_PROTOCOLS, (long)CURLPROTO_HTTPS);
+#endif
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, list);
+    // Small enough that anything slower is a stalled server, which must not hold up the install.
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, collectTail);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &sink);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+
+    const int64_t started = traceNow();
+    CURLcode res = curl_easy_perform(curl);
+    recordTransfer(curl, res);
+    if (traceEnabled())
+    {
+        tracePhases(curl, started, url);
+    }
+    releaseHandle(curl);
+    curl_slist_free_all(list);
+
+    if (res != CURLE_OK) return false;
+    body.assign(data.begin(), data.end());
+    return true;
+}
+
+void setNetworkLimit(int64_t bytesPerSecond)
+{
+    network.setRate(bytesPerSecond);
+}
+
+TransferStats getTransferStats()
+{
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return stats;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <vector>
+
+struct TransferStats
+{
+    uint64_t transfers = 0;
+    uint64_t failedTransfers = 0;
+    uint64_t newConnections = 0;
+    uint64_t reusedConnections = 0;
+    // Transfers answered with 304, reusing the copy already on disk.
+    uint64_t notModified = 0;
+    uint64_t bytesReceived = 0;
+};
+
+// One long-lived transfer context shared by every download: DNS cache,
+// connection pool and TLS sessions live in a CURLSH, easy handles are pooled.
+bool netInit();
+void netCleanup();
+
+// Lets another thread steer a running download. Both fields are read on every
+// received chunk, so a ceiling can be lifted or a transfer stopped mid-flight.
+struct DownloadControl
+{
+    // Bytes per second, 0 for no limit.
+    std::atomic<int64_t> maxBytesPerSecond{ 0 };
+    std::atomic<bool> cancel{ false };
+};
+
+// Streams url to outputPath, hashing as bytes arrive. When expectedSha256 is set
+// a mismatching file is discarded and the download reported as failed. The body
+// arrives in "<outputPath>.part" and only replaces outputPath once complete.
+//
+// The response's ETag and Last-Modified are kept in "<outputPath>.validators". A
+// later download of the same url to the same place sends them as If-None-Match and
+// If-Modified-Since; a 304 keeps the existing file (after checking it against
+// expectedSha256, when set) instead of transferring it again. With
+// minBytesPerSecond set, a transfer that stays below it for stallSeconds is
+// aborted, so the caller can fail over to another source.
+bool downloadFile(const std::string& url, const std::string& outputPath, const std::string& expectedSha256 = "",
+    DownloadControl* control = nullptr, int64_t minBytesPerSecond = 0);
+
+constexpr long stallSeconds = 10;
+
+// The url the copy downloadFile() left at outputPath came from, as recorded with
+// its validators; empty when there are none.
+std::string downloadedFrom(const std::string& outputPath);
+
+// Sends a one-byte ranged GET to every url at once and returns how long each took
+// to answer in microseconds. Failures get -1, and so does every probe still
+// pending when the first one succeeded or when timeoutMs ran out. The winner's
+// connection stays pooled for the download that follows.
+std::vector<int64_t> raceProbes(const std::vector<std::string>& urls, long timeoutMs);
+
+// The last tailBytes of url (at most) through a suffix range request, and the size
+// of the whole file, e.g. to read a zip's central directory without the rest.
+// False when the server does not answer with a range.
+bool fetchTail(const std::string& url, size_t tailBytes, std::vector<uint8_t>& tail, uint64_t& totalSize);
+
+// The body of a small https document (at most maxBytes), e.g. a JSON API response,
+// sent with the extra headers given. Plain http is refused, redirects included, and
+// the server certificate is verified as for every transfer.
+bool fetchDocument(const std::string& url, size_t maxBytes, std::string& body,
+    const std::vector<std::string>& headers = {});
+
+// Ceiling for all transfers together in bytes per second, 0 for none (the default).
+// Applies on top of any per-download DownloadControl limit.
+void setNetworkLimit(int64_t bytesPerSecond);
+
+TransferStats getTransferStats();
@@ -0,0 +1,166 @@
+#include <payload.h>
+#include <platform.h>
+
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    const uint8_t* mapped = nullptr;
+    size_t mappedSize = 0;
+    std::vector<PayloadEntry> entries;
+
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = NULL;
+#endif
+
+    uint32_t readU32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+    }
+
+    uint64_t readU64(const uint8_t* p)
+    {
+        return uint64_t(readU32(p)) | uint64_t(readU32(p + 4)) << 32;
+    }
+
+    bool mapSelf()
+    {
+#ifdef _WIN32
+        const std::string path = getExecutablePath();
+        if (path.empty()) return false;
+
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (fileHandle == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size))
+        {
+            closePayload();
+            return false;
+        }
+
+        mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mappingHandle)
+        {
+            closePayload();
+            return false;
+        }
+
+        mapped = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        mappedSize = static_cast<size_t>(size.QuadPart);
+        return mapped != nullptr;
+#else
+        const std::string path = getExecutablePath();
+        if (path.empty()) return false;
+
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size <= 0)
+        {
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (view == MAP_FAILED) return false;
+
+        mapped = static_cast<const uint8_t*>(view);
+        mappedSize = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+
+    bool parseIndex()
+    {
+        const size_t magicLen = sizeof(payloadMagic) - 1;
+        if (mappedSize < payloadTrailerSize + magicLen) return false;
+
+        const uint8_t* tail = mapped + mappedSize - magicLen;
+        if (memcmp(tail, payloadMagic, magicLen) != 0) return false;
+
+        const uint8_t* trailer = tail - payloadTrailerSize;
+        const uint32_t count = readU32(trailer);
+        const uint64_t indexOffset = readU64(trailer + 4);
+        if (indexOffset > static_cast<uint64_t>(trailer - mapped)) return false;
+
+        const uint8_t* p = mapped + indexOffset;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (trailer - p < 4) return false;
+            const uint32_t nameLen = readU32(p);
+            p += 4;
+
+            if (static_cast<uint64_t>(trailer - p) < uint64_t(nameLen) + 16) return false;
+            PayloadEntry entry;
+            entry.name.assign(reinterpret_cast<const char*>(p), nameLen);
+            p += nameLen;
+
+            const uint64_t offset = readU64(p);
+            const uint64_t size = readU64(p + 8);
+            p += 16;
+
+            if (offset > indexOffset || size > indexOffset - offset) return false;
+            entry.data = mapped + offset;
+            entry.size = static_cast<size_t>(size);
+            entries.push_back(std::move(entry));
+        }
+
+        return !entries.empty();
+    }
+}
+
+bool openPayload()
+{
+    if (mapped) return !entries.empty();
+    if (!mapSelf()) return false;
+
+    if (!parseIndex())
+    {
+        closePayload();
+        return false;
+    }
+
+    return true;
+}
+
+void closePayload()
+{
+    entries.clear();
+
+#ifdef _WIN32
+    if (mapped) UnmapViewOfFile(mapped);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+    mappingHandle = NULL;
+    fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (mapped) munmap(const_cast<uint8_t*>(mapped), mappedSize);
+#endif
+
+    mapped = nullptr;
+    mappedSize = 0;
+}
+
+const PayloadEntry* findPayload(const std::string& name)
+{
+    for (const PayloadEntry& entry : entries)
+    {
+        if (entry.name == name) return &entry;
+    }
+    return nullptr;
+}
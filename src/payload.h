@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Offline builds carry the release archives appended to the executable:
+//
+//   [executable][archive 0]...[archive n-1][index][u32 count][u64 index offset]["SINEPAK1"]
+//
+// with one index record per archive: u32 name length, name, u64 offset, u64 size
+// (little endian, offsets from the start of the file).
+
+struct PayloadEntry
+{
+    std::string name;
+    const uint8_t* data;
+    size_t size;
+};
+
+// Maps the running executable read-only and parses the trailer. Returns false
+// (and leaves nothing mapped) for regular builds without a payload.
+bool openPayload();
+void closePayload();
+
+const PayloadEntry* findPayload(const std::string& name);
+
+constexpr char payloadMagic[] = "SINEPAK1";
+// u32 count + u64 index offset, followed by the magic.
+constexpr size_t payloadTrailerSize = 4 + 8;
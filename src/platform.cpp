@@ -0,0 +1,596 @@
+#include <platform.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <aclapi.h>
+#include <tlhelp32.h>
+#else
+#include <fcntl.h>
+#include <grp.h>
+#include <limits.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#if __APPLE__
+#include <mach-o/dyld.h>
+#include <sys/event.h>
+#endif
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/syscall.h>
+#endif
+
+bool fixFilePerms(const std::string& filepath) {
+#ifdef _WIN32
+    // Remove read-only attribute
+    DWORD attrs = GetFileAttributesA(filepath.c_str());
+    if (attrs != INVALID_FILE_ATTRIBUTES)
+    {
+        SetFileAttributesA(filepath.c_str(), attrs & ~FILE_ATTRIBUTE_READONLY);
+    }
+
+    // Get current user SID
+    HANDLE hToken;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken))
+    {
+        return false;
+    }
+
+    DWORD dwSize = 0;
+    GetTokenInformation(hToken, TokenUser, NULL, 0, &dwSize);
+    TOKEN_USER* pTokenUser = (TOKEN_USER*)malloc(dwSize);
+
+    if (!GetTokenInformation(hToken, TokenUser, pTokenUser, dwSize, &dwSize))
+    {
+        free(pTokenUser);
+        CloseHandle(hToken);
+        return false;
+    }
+
+    // Set owner to current user
+    DWORD result = SetNamedSecurityInfoA(
+        (LPSTR)filepath.c_str(),
+        SE_FILE_OBJECT,
+        OWNER_SECURITY_INFORMATION,
+        pTokenUser->User.Sid,
+        NULL, NULL, NULL
+    );
+
+    free(pTokenUser);
+    CloseHandle(hToken);
+
+    return (result == ERROR_SUCCESS);
+
+#else
+    struct stat st;
+    if (stat(filepath.c_str(), &st) != 0)
+        return false;
+
+    if (S_ISDIR(st.st_mode))
+    {
+        // Directories: 755
+        if (chmod(filepath.c_str(),
+                  S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) != 0)
+            return false;
+    }
+    else
+    {
+        // Files: 644
+        if (chmod(filepath.c_str(),
+                  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) != 0)
+            return false;
+    }
+
+    return false;
+#endif
+}
+
+std::string shellEscape(const std::string& input)
+{
+    // POSIX shell-safe escaping using single quotes
+    // abc'def → 'abc'"'"'def'
+    std::string out;
+    out.reserve(input.size() + 2);
+
+    out.push_back('\'');
+    for (char c : input)
+    {
+        if (c == '\'')
+            out += "'\"'\"'";
+        else
+            out.push_back(c);
+    }
+    out.push_back('\'');
+
+    return out;
+}
+
+std::string getExecutablePath()
+{
+#ifdef _WIN32
+    char path[MAX_PATH];
+    DWORD len = GetModuleFileNameA(NULL, path, MAX_PATH);
+    return len == 0 ? "" : std::string(path, len);
+#elif defined(__APPLE__)
+    char path[PATH_MAX];
+    uint32_t size = sizeof(path);
+    return _NSGetExecutablePath(path, &size) == 0 ? std::string(path) : "";
+#else
+    char path[PATH_MAX];
+    ssize_t len = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    return len <= 0 ? "" : std::string(path, len);
+#endif
+}
+
+#ifdef __linux__
+namespace
+{
+    // Whether the program a /proc/<pid> entry runs has processName in its path.
+    bool commandMatches(const std::filesystem::path& entry, const std::string& processName)
+    {
+        std::ifstream cmdline(entry / "cmdline");
+        std::string content;
+        std::getline(cmdline, content, '\0');
+        return content.find(processName) != std::string::npos;
+    }
+}
+#endif
+
+bool isProcessRunning(const std::string& processName) {
+#ifdef _WIN32
+    // Windows implementation
+    HANDLE hSnapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (hSnapshot == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    PROCESSENTRY32 pe32;
+    pe32.dwSize = sizeof(PROCESSENTRY32);
+
+    if (Process32First(hSnapshot, &pe32)) {
+        do {
+            if (processName == pe32.szExeFile) {
+                CloseHandle(hSnapshot);
+                return true;
+            }
+        } while (Process32Next(hSnapshot, &pe32));
+    }
+
+    CloseHandle(hSnapshot);
+    return false;
+
+#elif __linux__
+    // Linux implementation
+    for (const auto& entry : std::filesystem::directory_iterator("/proc")) {
+        if (entry.is_directory() && commandMatches(entry.path(), processName)) {
+            return true;
+        }
+    }
+    return false;
+
+#elif __APPLE__
+    // macOS implementation
+    std::string command = "pgrep -x " + processName;
+    std::array<char, 128> buffer;
+    std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
+
+    if (!pipe) {
+        return false;
+    }
+
+    return fgets(buffer.data(), buffer.size(), pipe.get()) != nullptr;
+
+#else
+    // Unsupported platform
+    return false;
+#endif
+}
+
+bool canWriteTo(const std::string& path)
+{
+    // What does not exist yet gets created in the nearest folder that does.
+    std::error_code ec;
+    std::filesystem::path existing = std::filesystem::absolute(path, ec);
+    while (!std::filesystem::exists(existing, ec) && existing.has_relative_path())
+    {
+        existing = existing.parent_path();
+    }
+    const bool directory = std::filesystem::is_directory(existing, ec);
+
+#ifdef _WIN32
+    const std::string target = existing.string();
+    const DWORD attributes = GetFileAttributesA(target.c_str());
+    if (attributes == INVALID_FILE_ATTRIBUTES) return false;
+    if (!directory && (attributes & FILE_ATTRIBUTE_READONLY)) return false;
+
+    const SECURITY_INFORMATION parts = OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION | DACL_SECURITY_INFORMATION;
+    DWORD length = 0;
+    GetFileSecurityA(target.c_str(), parts, nullptr, 0, &length);
+    std::vector<uint8_t> descriptor(length);
+    if (length == 0 || !GetFileSecurityA(target.c_str(), parts, descriptor.data(), length, &length)) return false;
+
+    // AccessCheck wants an impersonation token; the process token is a primary one.
+    HANDLE process = nullptr;
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY | TOKEN_DUPLICATE, &process)) return false;
+    const BOOL duplicated = DuplicateToken(process, SecurityImpersonation, &token);
+    CloseHandle(process);
+    if (!duplicated) return false;
+
+    GENERIC_MAPPING mapping = { FILE_GENERIC_READ, FILE_GENERIC_WRITE, FILE_GENERIC_EXECUTE, FILE_ALL_ACCESS };
+    DWORD desired = directory ? (FILE_ADD_FILE | FILE_ADD_SUBDIRECTORY) : FILE_GENERIC_WRITE;
+    MapGenericMask(&desired, &mapping);
+
+    PRIVILEGE_SET privileges = {};
+    DWORD privilegesLength = sizeof(privileges);
+    DWORD granted = 0;
+    BOOL allowed = FALSE;
+    const BOOL checked = AccessCheck(descriptor.data(), token, desired, &mapping, &privileges, &privilegesLength, &granted, &allowed);
+    CloseHandle(token);
+    return checked && allowed;
+#else
+    // The effective IDs, as the writes themselves would use; a read-only mount fails with EROFS.
+    return faccessat(AT_FDCWD, existing.c_str(), directory ? W_OK | X_OK : W_OK, AT_EACCESS) == 0;
+#endif
+}
+
+void matchOwnership(const std::string& path, const std::string& reference)
+{
+#ifndef _WIN32
+    struct stat owner;
+    if (geteuid() != 0 || stat(reference.c_str(), &owner) != 0) return;
+
+    lchown(path.c_str(), owner.st_uid, owner.st_gid);
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(std::filesystem::symlink_status(path, ec))) return;
+    for (auto it = std::filesystem::recursive_directory_iterator(path, ec);
+         it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+    {
+        if (ec) break;
+        lchown(it->path().c_str(), owner.st_uid, owner.st_gid);
+    }
+#else
+    (void)path;
+    (void)reference;
+#endif
+}
+
+bool becomeOwnerOf(const std::string& path, std::string& error)
+{
+#ifndef _WIN32
+    if (geteuid() != 0) return true;
+
+    struct stat owner;
+    if (lstat(path.c_str(), &owner) != 0 || !S_ISDIR(owner.st_mode))
+    {
+        error = path + " is not a folder.";
+        return false;
+    }
+    if (owner.st_uid == 0) return true;
+
+    // The groups go first: without root they can no longer be changed. The final
+    // setuid(0) must fail, or root could be taken back.
+    const gid_t group = owner.st_gid;
+    if (setgroups(1, &group) != 0 || setgid(owner.st_gid) != 0 || setuid(owner.st_uid) != 0
+        || geteuid() != owner.st_uid || setuid(0) == 0)
+    {
+        error = "Failed to switch to the owner of " + path + ".";
+        return false;
+    }
+    return true;
+#else
+    (void)path;
+    (void)error;
+    return true;
+#endif
+}
+
+void attachConsole()
+{
+#ifdef _WIN32
+    if (AttachConsole(ATTACH_PARENT_PROCESS))
+    {
+        freopen("CONOUT$", "w", stdout);
+        freopen("CONOUT$", "w", stderr);
+    }
+#endif
+}
+
+std::string systemLocale()
+{
+#ifdef _WIN32
+    wchar_t name[LOCALE_NAME_MAX_LENGTH];
+    if (GetUserDefaultLocaleName(name, LOCALE_NAME_MAX_LENGTH) <= 0) return "";
+
+    // Locale names are plain ASCII ("de-DE").
+    std::string locale;
+    for (const wchar_t* c = name; *c; ++c)
+    {
+        locale.push_back(static_cast<char>(*c));
+    }
+    return locale;
+#else
+    // Same precedence as setlocale: LC_ALL, then LC_MESSAGES, then LANG.
+    const char* value = nullptr;
+    for (const char* variable : { "LC_ALL", "LC_MESSAGES", "LANG" })
+    {
+        value = std::getenv(variable);
+        if (value && *value) break;
+    }
+    if (!value) return "";
+
+    // "de_DE.UTF-8@euro" -> "de-DE"
+    std::string locale(value, strcspn(value, ".@"));
+    if (locale.empty() || locale == "C" || locale == "POSIX") return "";
+    std::replace(locale.begin(), locale.end(), '_', '-');
+    return locale;
+#endif
+}
+
+bool exchangePaths(const std::string& first, const std::string& second)
+{
+#if defined(__linux__) && defined(SYS_renameat2)
+    // Through syscall(), as glibc only wraps renameat2 since 2.28.
+    constexpr unsigned renameExchange = 1 << 1;
+    if (syscall(SYS_renameat2, AT_FDCWD, first.c_str(), AT_FDCWD, second.c_str(), renameExchange) == 0)
+    {
+        return true;
+    }
+    // EINVAL: the filesystem cannot exchange; anything else would fail below too.
+    if (errno != EINVAL && errno != ENOSYS) return false;
+#elif __APPLE__
+    if (renamex_np(first.c_str(), second.c_str(), RENAME_SWAP) == 0)
+    {
+        return true;
+    }
+    if (errno != ENOTSUP) return false;
+#endif
+
+    std::error_code ec;
+    const std::string aside = second + ".exchange";
+    std::filesystem::remove_all(aside, ec);
+    std::filesystem::rename(second, aside, ec);
+    if (ec) return false;
+    std::filesystem::rename(first, second, ec);
+    if (ec)
+    {
+        std::filesystem::rename(aside, second, ec);
+        return false;
+    }
+    std::filesystem::rename(aside, first, ec);
+    return !ec;
+}
+
+void lowerProcessPriority()
+{
+#ifdef _WIN32
+    // Lowers CPU, I/O and memory priority of the whole process in one go.
+    SetPriorityClass(GetCurrentProcess(), PROCESS_MODE_BACKGROUND_BEGIN);
+#else
+    // Nice values are per thread on Linux; new threads inherit them.
+    setpriority(PRIO_PROCESS, 0, 10);
+#if __APPLE__
+    setiopolicy_np(IOPOL_TYPE_DISK, IOPOL_SCOPE_PROCESS, IOPOL_THROTTLE);
+#elif defined(__linux__)
+    // Lowest level of the best-effort class rather than the idle class: idle I/O
+    // only runs when the disk is otherwise quiet and can wait forever on a busy host.
+    constexpr int ioprioWhoProcess = 1;
+    constexpr int ioprioClassBestEffort = 2;
+    constexpr int ioprioClassShift = 13;
+    syscall(SYS_ioprio_set, ioprioWhoProcess, 0, (ioprioClassBestEffort << ioprioClassShift) | 7);
+#endif
+#endif
+}
+
+namespace
+{
+    // Processes matched as isProcessRunning() matches them, leaving out this one.
+#ifdef _WIN32
+    std::vector<DWORD> findProcesses(const std::vector<std::string>& processNames)
+    {
+        std::vector<DWORD> pids;
+        HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+        if (snapshot == INVALID_HANDLE_VALUE) return pids;
+
+        PROCESSENTRY32 entry;
+        entry.dwSize = sizeof(entry);
+        for (BOOL more = Process32First(snapshot, &entry); more; more = Process32Next(snapshot, &entry))
+        {
+            const bool matches = std::find(processNames.begin(), processNames.end(), entry.szExeFile) != processNames.end();
+            if (matches && entry.th32ProcessID != GetCurrentProcessId())
+            {
+                pids.push_back(entry.th32ProcessID);
+            }
+        }
+        CloseHandle(snapshot);
+        return pids;
+    }
+#elif __linux__
+    std::vector<pid_t> findProcesses(const std::vector<std::string>& processNames)
+    {
+        std::vector<pid_t> pids;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc", ec))
+        {
+            const std::string name = entry.path().filename().string();
+            if (!std::all_of(name.begin(), name.end(), [](unsigned char c) { return std::isdigit(c); })) continue;
+
+            const pid_t pid = static_cast<pid_t>(std::stol(name));
+            if (pid == getpid()) continue;
+            for (const std::string& processName : processNames)
+            {
+                if (commandMatches(entry.path(), processName))
+                {
+                    pids.push_back(pid);
+                    break;
+                }
+            }
+        }
+        return pids;
+    }
+#elif __APPLE__
+    std::vector<pid_t> findProcesses(const std::vector<std::string>& processNames)
+    {
+        std::vector<pid_t> pids;
+        for (const std::string& processName : processNames)
+        {
+            const std::string command = "pgrep -x " + shellEscape(processName);
+            std::unique_ptr<FILE, decltype(&pclose)> pipe(popen(command.c_str(), "r"), pclose);
+            if (!pipe) continue;
+
+            std::array<char, 32> line;
+            while (fgets(line.data(), line.size(), pipe.get()))
+            {
+                const pid_t pid = static_cast<pid_t>(std::atol(line.data()));
+                if (pid > 0 && pid != getpid()) pids.push_back(pid);
+            }
+        }
+        return pids;
+    }
+#endif
+
+    // Waits up to timeoutMs for one of the matching processes to exit. False when
+    // none was running to begin with.
+    bool waitForAnyExit(const std::vector<std::string>& processNames, int64_t timeoutMs)
+    {
+#ifdef _WIN32
+        std::vector<HANDLE> handles;
+        for (DWORD pid : findProcesses(processNames))
+        {
+            HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+            if (process) handles.push_back(process);
+            if (handles.size() == MAXIMUM_WAIT_OBJECTS) break;
+        }
+        if (handles.empty()) return false;
+
+        WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE,
+            static_cast<DWORD>(std::min<int64_t>(timeoutMs, INFINITE - 1)));
+        for (HANDLE process : handles)
+        {
+            CloseHandle(process);
+        }
+        return true;
+#elif __linux__
+        const std::vector<pid_t> pids = findProcesses(processNames);
+        if (pids.empty()) return false;
+
+        std::vector<pollfd> fds;
+        bool unwaitable = false;
+        for (pid_t pid : pids)
+        {
+#ifdef SYS_pidfd_open
+            const int fd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+#else
+            const int fd = -1;
+            errno = ENOSYS;
+#endif
+            if (fd >= 0)
+            {
+                fds.push_back({ fd, POLLIN, 0 });
+            }
+            else if (errno != ESRCH)
+            {
+                unwaitable = true;
+            }
+        }
+
+        if (unwaitable)
+        {
+            // Kernels before 5.3 have no pidfd_open; look again every few seconds there.
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<int64_t>(timeoutMs, 5000)));
+        }
+        else if (!fds.empty())
+        {
+            // A pidfd becomes readable when its process exits.
+            poll(fds.data(), fds.size(), static_cast<int>(std::min<int64_t>(timeoutMs, INT_MAX)));
+        }
+        for (const pollfd& fd : fds)
+        {
+            close(fd.fd);
+        }
+        return true;
+#elif __APPLE__
+        const std::vector<pid_t> pids = findProcesses(processNames);
+        if (pids.empty()) return false;
+
+        const int queue = kqueue();
+        if (queue < 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<int64_t>(timeoutMs, 5000)));
+            return true;
+        }
+        for (pid_t pid : pids)
+        {
+            struct kevent change;
+            EV_SET(&change, pid, EVFILT_PROC, EV_ADD | EV_ONESHOT, NOTE_EXIT, 0, nullptr);
+            // ESRCH: gone already, which the next look finds.
+            kevent(queue, &change, 1, nullptr, 0, nullptr);
+        }
+
+        struct kevent event;
+        const timespec timeout = { static_cast<time_t>(timeoutMs / 1000), static_cast<long>(timeoutMs % 1000) * 1000000 };
+        kevent(queue, nullptr, 0, &event, 1, &timeout);
+        close(queue);
+        return true;
+#else
+        (void)timeoutMs;
+        return false;
+#endif
+    }
+}
+
+bool waitForProcessExit(const std::vector<std::string>& processNames, int64_t timeoutMs)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    for (;;)
+    {
+        const int64_t remaining = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        // Looked up again after every exit: a browser runs as several processes and may have been restarted.
+        if (!waitForAnyExit(processNames, remaining)) return true;
+        if (remaining == 0) return false;
+    }
+}
+
+std::string makePrivateTempDir(const std::string& prefix)
+{
+    std::error_code ec;
+    const std::filesystem::path base = std::filesystem::temp_directory_path(ec);
+    if (ec) return "";
+
+#ifdef _WIN32
+    // %TEMP% is per user already; the random name keeps concurrent runs apart.
+    for (int attempt = 0; attempt < 16; ++attempt)
+    {
+        char name[32];
+        std::snprintf(name, sizeof(name), "-%08lx%04x", GetTickCount(), static_cast<unsigned>(std::rand() & 0xffff));
+        const std::string path = (base / (prefix + name)).string();
+        if (CreateDirectoryA(path.c_str(), nullptr)) return path;
+        if (GetLastError() != ERROR_ALREADY_EXISTS) return "";
+    }
+    return "";
+#else
+    // mkdtemp creates the folder 0700 under a name nobody can have taken beforehand.
+    std::string pattern = (base / (prefix + "-XXXXXX")).string();
+    return mkdtemp(pattern.data()) ? pattern : "";
+#endif
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+bool fixFilePerms(const std::string& filepath);
+
+std::string shellEscape(const std::string& input);
+
+std::string getExecutablePath();
+
+bool isProcessRunning(const std::string& processName);
+
+// Blocks until no process of these names (matched as isProcessRunning() does) is
+// left, or timeoutMs passes; true in the first case. Sleeps on the processes
+// themselves rather than polling: a pidfd on Linux 5.3+, a kqueue on macOS and
+// process handles on Windows.
+bool waitForProcessExit(const std::vector<std::string>& processNames, int64_t timeoutMs);
+
+// Whether this process can write path, or create it when it does not exist yet,
+// judged from permissions alone without writing anything: faccessat with the
+// effective IDs on POSIX, an access check of the ACL against the process token on Windows.
+bool canWriteTo(const std::string& path);
+
+// Creates a new, empty folder under the temp directory that only this user can
+// enter (mkdtemp on POSIX), so another local user can neither claim the name
+// first nor plant files in it. Empty on failure.
+std::string makePrivateTempDir(const std::string& prefix);
+
+// Gives path (recursively) the owner and group of reference. Only does anything
+// on POSIX when running as root, e.g. installing into other users' profiles.
+void matchOwnership(const std::string& path, const std::string& reference);
+
+// Makes this process the owner of the folder at path (POSIX, as root): its group,
+// then its user, for good, so from here on it can write nothing the owner could not.
+// Refuses a path that is a symlink or not a folder. Nothing changes when not running
+// as root or when root owns the folder.
+bool becomeOwnerOf(const std::string& path, std::string& error);
+
+// Windows GUI builds start without a console; command-line modes reattach to the caller's.
+void attachConsole();
+
+// The user's UI locale as a BCP 47 tag ("de-DE"), or empty when it is unset or "C".
+std::string systemLocale();
+
+// Swaps two existing files or folders on the same filesystem. Atomic where the OS
+// can exchange paths (renameat2 RENAME_EXCHANGE on Linux, renamex_np RENAME_SWAP on
+// macOS); elsewhere, or when the filesystem refuses, a sequence of three renames.
+bool exchangePaths(const std::string& first, const std::string& second);
+
+// Drops CPU and I/O priority below the user's own programs. Applies to the calling
+// thread and every thread it starts afterwards, so call it before starting any.
+void lowerProcessPriority();
@@ -0,0 +1,99 @@
+#include <prefetch.h>
+#include <install.h>
+#include <mirrors.h>
+#include <net.h>
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // In install order, so the first download step is the first to finish.
+    const char* const archives[] = { "program.zip", "profile.zip", "engine.zip", "locales.zip" };
+
+    std::thread worker;
+    DownloadControl control;
+    std::mutex statusMutex;
+    std::map<std::string, PrefetchStatus> status;
+    // Paths that were not in the cache before this run; only the worker writes it until it is joined.
+    std::vector<std::string> added;
+
+    void setStatus(const std::string& name, PrefetchStatus value)
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        status[name] = value;
+    }
+
+    void run(std::string downloadsFolder)
+    {
+        for (const char* archive : archives)
+        {
+            if (control.cancel)
+            {
+                setStatus(archive, PrefetchStatus::NONE);
+                continue;
+            }
+
+            const std::string path = downloadsFolder + "/" + archive;
+            std::error_code ec;
+            if (!std::filesystem::exists(path, ec))
+            {
+                added.push_back(path);
+            }
+            const bool ok = digestAvailable(archive)
+                && downloadMirrored(archiveUrl(archive), path, pinnedDigest(archive), &control);
+            setStatus(archive, ok ? PrefetchStatus::READY : control.cancel ? PrefetchStatus::NONE : PrefetchStatus::FAILED);
+        }
+    }
+}
+
+void prefetchStart(const std::string& downloadsFolder, int64_t maxBytesPerSecond)
+{
+    if (worker.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(statusMutex);
+        for (const char* archive : archives)
+        {
+            status[archive] = PrefetchStatus::PENDING;
+        }
+    }
+
+    control.cancel = false;
+    control.maxBytesPerSecond = maxBytesPerSecond;
+    added.clear();
+    worker = std::thread(run, downloadsFolder);
+}
+
+PrefetchStatus prefetchStatus(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(statusMutex);
+    auto it = status.find(name);
+    return it == status.end() ? PrefetchStatus::NONE : it->second;
+}
+
+void prefetchHurry()
+{
+    control.maxBytesPerSecond = 0;
+}
+
+void prefetchCancel(bool discard)
+{
+    if (!worker.joinable()) return;
+
+    control.cancel = true;
+    worker.join();
+
+    if (discard)
+    {
+        std::error_code ec;
+        for (const std::string& path : added)
+        {
+            std::filesystem::remove(path, ec);
+            std::filesystem::remove(path + ".validators", ec);
+        }
+    }
+}
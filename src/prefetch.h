@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Fetches the release archives into the archive cache in the background while
+// the user is still in the wizard. The URLs only depend on the compiled-in
+// versions, so nothing the user picks changes what is downloaded.
+
+enum class PrefetchStatus
+{
+    NONE,     // not part of the prefetch (or it was cancelled before starting)
+    PENDING,
+    READY,    // downloaded and verified
+    FAILED
+};
+
+// maxBytesPerSecond of 0 means no ceiling.
+void prefetchStart(const std::string& downloadsFolder, int64_t maxBytesPerSecond);
+PrefetchStatus prefetchStatus(const std::string& name);
+// The user is now waiting on the download: drop the ceiling.
+void prefetchHurry();
+// Stops the running transfer and waits for the worker. Safe to call when nothing
+// was started. With discard, the archives this run brought into the cache are
+// removed again, for when the wizard was left before installing.
+void prefetchCancel(bool discard = false);
@@ -0,0 +1,397 @@
+#include <preflight.h>
+#include <deferred.h>
+#include <extract.h>
+#include <install.h>
+#include <mirrors.h>
+#include <net.h>
+#include <payload.h>
+#include <platform.h>
+#include <trace.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <utility>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    // Enough for the central directory of every release archive in one read.
+    constexpr size_t tailBytes = 64 << 10;
+    // Every file written is assumed to take whole blocks of this size.
+    constexpr uint64_t blockSize = 4096;
+
+    constexpr uint32_t endSignature = 0x06054b50;
+    constexpr uint32_t zip64EndSignature = 0x06064b50;
+    constexpr uint32_t zip64LocatorSignature = 0x07064b50;
+    constexpr uint32_t headerSignature = 0x02014b50;
+    constexpr size_t endSize = 22;
+    constexpr size_t zip64EndSize = 56;
+    constexpr size_t zip64LocatorSize = 20;
+    constexpr size_t headerSize = 46;
+
+    struct ZipEntry
+    {
+        std::string name;
+        uint64_t size;
+    };
+
+    struct Listing
+    {
+        bool ok = false;
+        // Whether the archive still has to be downloaded, and how big it is.
+        bool download = false;
+        uint64_t archiveSize = 0;
+        std::vector<ZipEntry> entries;
+    };
+
+    struct TargetCheck
+    {
+        bool writable = true;
+        size_t replaced = 0;
+        uint64_t required = 0;
+        // Everything the archives hold, as a staged copy of them takes.
+        uint64_t total = 0;
+    };
+
+    uint16_t le16(const uint8_t* p)
+    {
+        return static_cast<uint16_t>(p[0] | p[1] << 8);
+    }
+
+    uint32_t le32(const uint8_t* p)
+    {
+        return le16(p) | static_cast<uint32_t>(le16(p + 2)) << 16;
+    }
+
+    uint64_t le64(const uint8_t* p)
+    {
+        return le32(p) | static_cast<uint64_t>(le32(p + 4)) << 32;
+    }
+
+    uint64_t blocks(uint64_t bytes)
+    {
+        return (bytes + blockSize - 1) / blockSize * blockSize;
+    }
+
+    // Lists the files of a zip of fileSize bytes from its last tailSize bytes. When
+    // the central directory starts before them, needed says how many it takes.
+    bool parseCentralDirectory(const uint8_t* tail, size_t tailSize, uint64_t fileSize,
+        std::vector<ZipEntry>& entries, uint64_t& needed)
+    {
+        if (tailSize < endSize || fileSize < tailSize) return false;
+        const uint64_t tailStart = fileSize - tailSize;
+
+        // The end record is followed by a comment of at most 64 KiB.
+        size_t end = tailSize - endSize;
+        while (le32(tail + end) != endSignature)
+        {
+            if (end == 0 || tailSize - end > endSize + 0xffff) return false;
+            --end;
+        }
+
+        uint64_t count = le16(tail + end + 10);
+        uint64_t directorySize = le32(tail + end + 12);
+        uint64_t directoryOffset = le32(tail + end + 16);
+        if (count == 0xffff || directorySize == 0xffffffff || directoryOffset == 0xffffffff)
+        {
+            // Zip64: a locator right before the end record points at the real numbers.
+            if (end < zip64LocatorSize || le32(tail + end - zip64LocatorSize) != zip64LocatorSignature) return false;
+            const uint64_t record = le64(tail + end - zip64LocatorSize + 8);
+            if (record < tailStart)
+            {
+                needed = fileSize - record;
+                return false;
+            }
+            const uint8_t* zip64 = tail + (record - tailStart);
+            if (record - tailStart + zip64EndSize > tailSize || le32(zip64) != zip64EndSignature) return false;
+            count = le64(zip64 + 32);
+            directorySize = le64(zip64 + 40);
+            directoryOffset = le64(zip64 + 48);
+        }
+
+        if (directoryOffset < tailStart)
+        {
+            needed = fileSize - directoryOffset;
+            return false;
+        }
+        if (directoryOffset - tailStart + directorySize > tailSize) return false;
+
+        const uint8_t* header = tail + (directoryOffset - tailStart);
+        const uint8_t* directoryEnd = header + directorySize;
+        entries.clear();
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            if (directoryEnd - header < static_cast<ptrdiff_t>(headerSize) || le32(header) != headerSignature) return false;
+            const size_t nameLength = le16(header + 28);
+            const size_t extraLength = le16(header + 30);
+            const size_t commentLength = le16(header + 32);
+            const size_t recordSize = headerSize + nameLength + extraLength + commentLength;
+            if (directoryEnd - header < static_cast<ptrdiff_t>(recordSize)) return false;
+
+            uint64_t size = le32(header + 24);
+            if (size == 0xffffffff)
+            {
+                // A saturated size is in the zip64 extra field, which then leads with it.
+                const uint8_t* extra = header + headerSize + nameLength;
+                const uint8_t* extraEnd = extra + extraLength;
+                while (extraEnd - extra >= 4 && extraEnd - extra >= 4 + le16(extra + 2))
+                {
+                    if (le16(extra) == 0x0001 && le16(extra + 2) >= 8)
+                    {
+                        size = le64(extra + 4);
+                        break;
+                    }
+                    extra += 4 + le16(extra + 2);
+                }
+            }
+
+            std::string name(reinterpret_cast<const char*>(header + headerSize), nameLength);
+            if (!name.empty() && name.back() != '/')
+            {
+                entries.push_back({ std::move(name), size });
+            }
+            header += recordSize;
+        }
+        return true;
+    }
+
+    // Reads the last bytes (at most) of an archive and the size of all of it.
+    using TailReader = std::function<bool(size_t bytes, std::vector<uint8_t>& tail, uint64_t& fileSize)>;
+
+    // One read normally; a second, larger one when the directory did not fit the first.
+    bool listFromTail(const TailReader& readTail, Listing& listing)
+    {
+        size_t want = tailBytes;
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            std::vector<uint8_t> tail;
+            uint64_t fileSize = 0;
+            if (!readTail(want, tail, fileSize)) return false;
+
+            uint64_t needed = 0;
+            if (parseCentralDirectory(tail.data(), tail.size(), fileSize, listing.entries, needed))
+            {
+                listing.archiveSize = fileSize;
+                return true;
+            }
+            if (needed <= want) return false;
+            want = static_cast<size_t>(needed);
+        }
+        return false;
+    }
+
+    Listing listArchive(const std::string& downloadsFolder, const std::string& name, bool offline)
+    {
+        TraceSpan span("list", "preflight", name);
+        Listing listing;
+
+        if (const PayloadEntry* embedded = findPayload(name))
+        {
+            uint64_t needed = 0;
+            listing.ok = parseCentralDirectory(embedded->data, embedded->size, embedded->size, listing.entries, needed);
+            return listing;
+        }
+        if (offline) return listing;
+
+        // A copy from an earlier run or the prefetcher saves the request.
+        const std::string local = downloadsFolder + "/" + name;
+        std::error_code ec;
+        if (std::filesystem::is_regular_file(local, ec))
+        {
+            listing.ok = listFromTail([&](size_t bytes, std::vector<uint8_t>& tail, uint64_t& fileSize) {
+                std::ifstream file(local, std::ios::binary | std::ios::ate);
+                fileSize = static_cast<uint64_t>(file.tellg());
+                tail.resize(static_cast<size_t>(std::min<uint64_t>(bytes, fileSize)));
+                file.seekg(static_cast<std::streamoff>(fileSize - tail.size()));
+                file.read(reinterpret_cast<char*>(tail.data()), static_cast<std::streamsize>(tail.size()));
+                return static_cast<bool>(file);
+            }, listing);
+            if (listing.ok) return listing;
+        }
+
+        listing.download = true;
+        for (const std::string& url : mirrorCandidates(archiveUrl(name)))
+        {
+            listing.ok = listFromTail([&](size_t bytes, std::vector<uint8_t>& tail, uint64_t& fileSize) {
+                return fetchTail(url, bytes, tail, fileSize);
+            }, listing);
+            if (listing.ok) break;
+        }
+        return listing;
+    }
+
+    // What extracting the archives into dir takes. A staged install writes
+    // everything next to the live files; an extraction in place only needs room
+    // for what a replaced file grows by.
+    TargetCheck checkTarget(const std::string& dir, const std::vector<std::pair<Deferred<Listing>, EntryFilter>>& archives, bool staged)
+    {
+        TraceSpan span("target", "preflight", dir);
+        TargetCheck check;
+        check.writable = canWriteTo(dir);
+
+        for (const auto& [deferred, filter] : archives)
+        {
+            const Listing& listing = deferred.get();
+            for (const ZipEntry& entry : listing.entries)
+            {
+                if (filter && !filter(entry.name)) continue;
+                check.total += blocks(entry.size);
+
+                std::error_code ec;
+                const std::filesystem::path path = std::filesystem::path(dir) / entry.name;
+                const uint64_t existing = std::filesystem::file_size(path, ec);
+                if (ec)
+                {
+                    check.required += blocks(entry.size);
+                    continue;
+                }
+
+                ++check.replaced;
+                check.writable = check.writable && canWriteTo(path.string());
+                if (staged)
+                {
+                    check.required += blocks(entry.size);
+                }
+                else if (blocks(entry.size) > blocks(existing))
+                {
+                    check.required += blocks(entry.size) - blocks(existing);
+                }
+            }
+        }
+        return check;
+    }
+
+    // Folders on the same filesystem share one entry: a device number on POSIX, a volume root on Windows.
+    std::string filesystemOf(const std::string& dir, std::filesystem::path& existing)
+    {
+        std::error_code ec;
+        existing = std::filesystem::absolute(dir, ec);
+        while (!std::filesystem::exists(existing, ec) && existing.has_relative_path())
+        {
+            existing = existing.parent_path();
+        }
+#ifdef _WIN32
+        return existing.root_name().string();
+#else
+        struct stat st;
+        return stat(existing.c_str(), &st) == 0 ? std::to_string(st.st_dev) : existing.string();
+#endif
+    }
+
+    std::string megabytes(uint64_t bytes)
+    {
+        return std::to_string((bytes + (1 << 20) - 1) >> 20) + " MB";
+    }
+}
+
+PreflightPlan planInstall(const PreflightOptions& options)
+{
+    TraceSpan span("preflight", "install");
+    PreflightPlan plan;
+
+    // Every listing starts right away; the target checks wait only on their own.
+    std::map<std::string, Deferred<Listing>> listings;
+    std::vector<std::string> names;
+    if (options.installBrowser)
+    {
+        names.push_back("program.zip");
+    }
+    if (options.installProfile)
+    {
+        names.insert(names.end(), { "profile.zip", "engine.zip", "locales.zip" });
+    }
+    for (const std::string& name : names)
+    {
+        const std::string downloadsFolder = options.downloadsFolder;
+        const bool offline = options.offline;
+        listings.emplace(name, Deferred<Listing>([=]() { return listArchive(downloadsFolder, name, offline); }));
+    }
+
+    std::vector<std::pair<std::string, Deferred<TargetCheck>>> targets;
+    if (!options.browserPath.empty())
+    {
+        std::vector<std::pair<Deferred<Listing>, EntryFilter>> archives;
+        if (options.installBrowser)
+        {
+            archives.emplace_back(listings.at("program.zip"), nullptr);
+        }
+        const std::string dir = options.browserPath;
+        targets.emplace_back(dir, Deferred<TargetCheck>([=]() { return checkTarget(dir, archives, false); }));
+    }
+    if (!options.profilePath.empty())
+    {
+        std::vector<std::pair<Deferred<Listing>, EntryFilter>> archives;
+        if (options.installProfile)
+        {
+            archives.emplace_back(listings.at("profile.zip"), nullptr);
+            archives.emplace_back(listings.at("engine.zip"), nullptr);
+            archives.emplace_back(listings.at("locales.zip"), localeFilter(options.profilePath));
+        }
+        const std::string dir = (std::filesystem::path(options.profilePath) / "chrome").string();
+        targets.emplace_back(dir, Deferred<TargetCheck>([=]() { return checkTarget(dir, archives, true); }));
+    }
+
+    std::map<std::string, PreflightVolume> volumes;
+    auto require = [&](const std::string& dir, uint64_t bytes) {
+        std::filesystem::path existing;
+        PreflightVolume& volume = volumes[filesystemOf(dir, existing)];
+        if (volume.path.empty())
+        {
+            // statvfs() on POSIX, GetDiskFreeSpaceEx() on Windows.
+            std::error_code ec;
+            volume.path = dir;
+            volume.available = std::filesystem::space(existing, ec).available;
+        }
+        volume.required += bytes;
+    };
+
+    for (size_t i = 0; i < targets.size(); ++i)
+    {
+        const TargetCheck& check = targets[i].second.get();
+        plan.replacedFiles += check.replaced;
+        (i == 0 && !options.browserPath.empty() ? plan.browserWritable : plan.profileWritable) = check.writable;
+        require(targets[i].first, check.required);
+
+        // The helper's staging copy lands on the temp filesystem, which may be a small tmpfs.
+        if (i == 0 && !options.browserPath.empty() && !check.writable && !options.stagingFolder.empty())
+        {
+            require(options.stagingFolder, check.total);
+        }
+    }
+
+    uint64_t downloads = 0;
+    for (const std::string& name : names)
+    {
+        const Listing& listing = listings.at(name).get();
+        if (!listing.ok)
+        {
+            plan.unsized.push_back(name);
+        }
+        else if (listing.download)
+        {
+            downloads += blocks(listing.archiveSize);
+        }
+    }
+    if (downloads > 0)
+    {
+        require(options.downloadsFolder, downloads);
+    }
+
+    for (const auto& entry : volumes)
+    {
+        const PreflightVolume& volume = entry.second;
+        plan.volumes.push_back(volume);
+        if (volume.required > volume.available)
+        {
+            plan.problems.push_back("Not enough space for " + volume.path + ": " + megabytes(volume.required)
+                + " needed, " + megabytes(volume.available) + " free.");
+        }
+    }
+    return plan;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Works out an install before any of it happens, so it fails (or asks for
+// elevation) up front instead of halfway through an extraction. Nothing is
+// downloaded and nothing written: the archives' central directories come from the
+// payload, a copy already in downloadsFolder or the tail of the release file (one
+// range request each), and write access is judged from permissions (canWriteTo).
+
+struct PreflightOptions
+{
+    // Left empty for whatever the install does not touch. An uninstall only needs
+    // the write checks, so it leaves the install flags off.
+    std::string browserPath;
+    std::string profilePath;
+    bool installBrowser = false;
+    bool installProfile = false;
+    std::string downloadsFolder;
+    bool offline = false;
+    // Where program.zip is extracted first when the browser folder turns out not
+    // to be writable and the elevated helper copies it over; empty when it never is.
+    std::string stagingFolder;
+};
+
+struct PreflightVolume
+{
+    // The first target found on this filesystem.
+    std::string path;
+    uint64_t required = 0;
+    uint64_t available = 0;
+};
+
+struct PreflightPlan
+{
+    // The folder itself and every file the install replaces in it.
+    bool browserWritable = true;
+    bool profileWritable = true;
+    // Existing files the archives overwrite (in the browser folder) or replace on the swap (in the profile).
+    size_t replacedFiles = 0;
+    std::vector<PreflightVolume> volumes;
+    // Archives whose size could not be worked out; the space checks leave them out.
+    std::vector<std::string> unsized;
+    // What makes the install fail as things stand, empty when it can go ahead.
+    // Missing write access is not one of them: that is what elevation is for.
+    std::vector<std::string> problems;
+};
+
+// The archive listings, target checks and free space queries all run in parallel.
+PreflightPlan planInstall(const PreflightOptions& options);
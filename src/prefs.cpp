@@ -0,0 +1,211 @@
+#include <prefs.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+    // The key of a `user_pref("key", value);` line, or an empty view for anything else.
+    std::string_view prefKey(const std::string& line)
+    {
+        size_t i = line.find_first_not_of(" \t");
+        if (i == std::string::npos || line.compare(i, 10, "user_pref(") != 0) return {};
+
+        i = line.find_first_not_of(" \t", i + 10);
+        if (i == std::string::npos || line[i] != '"') return {};
+
+        const size_t end = line.find('"', i + 1);
+        if (end == std::string::npos) return {};
+        return std::string_view(line).substr(i + 1, end - i - 1);
+    }
+
+    // Everything between the comma after the key and the closing ");".
+    std::string prefValue(const std::string& line, std::string_view key)
+    {
+        const size_t keyEnd = static_cast<size_t>(key.data() + key.size() - line.data()) + 1;
+        const size_t comma = line.find(',', keyEnd);
+        const size_t close = line.rfind(')');
+        if (comma == std::string::npos || close == std::string::npos || close < comma) return "";
+
+        const size_t begin = line.find_first_not_of(" \t", comma + 1);
+        const size_t end = line.find_last_not_of(" \t", close - 1);
+        if (begin == std::string::npos || end == std::string::npos || end < begin) return "";
+        return line.substr(begin, end - begin + 1);
+    }
+
+    std::string prefLine(const PrefValue& pref)
+    {
+        return "user_pref(\"" + pref.first + "\", " + pref.second + ");";
+    }
+}
+
+bool upsertPrefs(const std::string& prefsPath, const std::vector<PrefValue>& prefs)
+{
+    const std::string tempPath = prefsPath + ".sine-tmp";
+    std::vector<bool> written(prefs.size(), false);
+
+    // Only a prefs.js that does not exist yet may be read as empty; anything else
+    // unreadable would be replaced by a file with nothing but our prefs.
+    std::error_code ec;
+    const bool exists = std::filesystem::exists(prefsPath, ec);
+    // Larger stream buffers keep multi-megabyte prefs files to a few syscalls.
+    std::vector<char> inBuffer(1 << 16), outBuffer(1 << 16);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(inBuffer.data(), inBuffer.size());
+    in.open(prefsPath, std::ios::binary);
+    if (exists && !in.is_open())
+    {
+        std::cerr << "Cannot read " << prefsPath << ".\n";
+        return false;
+    }
+
+#ifndef _WIN32
+    // The profile may belong to another user (an elevated run, the agent or the
+    // helper write as root) who can plant anything at the temp name. A leftover is
+    // unlinked, never followed, and the new file must be one this call created.
+    unlink(tempPath.c_str());
+    const int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    FILE* out = fd < 0 ? nullptr : fdopen(fd, "wb");
+    if (fd >= 0 && !out) close(fd);
+#else
+    FILE* out = fopen(tempPath.c_str(), "wb");
+#endif
+    if (!out)
+    {
+        std::cerr << "Cannot write " << tempPath << ".\n";
+        return false;
+    }
+    setvbuf(out, outBuffer.data(), _IOFBF, outBuffer.size());
+    auto put = [out](const std::string& text, const char* end)
+    {
+        fwrite(text.data(), 1, text.size(), out);
+        fputs(end, out);
+    };
+    auto discard = [&]()
+    {
+        fclose(out);
+        std::remove(tempPath.c_str());
+    };
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        const std::string_view key = prefKey(line);
+        size_t match = prefs.size();
+        if (!key.empty())
+        {
+            for (size_t i = 0; i < prefs.size(); ++i)
+            {
+                if (key == prefs[i].first)
+                {
+                    match = i;
+                    break;
+                }
+            }
+        }
+
+        if (match == prefs.size())
+        {
+            put(line, "\n");
+        }
+        else if (!written[match])
+        {
+            // Keep a trailing \r so CRLF files stay consistent.
+            const bool crlf = !line.empty() && line.back() == '\r';
+            put(prefLine(prefs[match]), crlf ? "\r\n" : "\n");
+            written[match] = true;
+        }
+    }
+    const bool readFailed = in.bad();
+    in.close();
+    if (readFailed)
+    {
+        std::cerr << "Failed to read " << prefsPath << ".\n";
+        discard();
+        return false;
+    }
+
+    for (size_t i = 0; i < prefs.size(); ++i)
+    {
+        if (!written[i])
+        {
+            put(prefLine(prefs[i]), "\n");
+        }
+    }
+
+#ifndef _WIN32
+    // prefs.js is usually private to its user; the replacement must not widen that,
+    // nor change hands when written by root: the browser has to keep reading and
+    // writing it. A new prefs.js goes to the owner of the profile folder. Both act
+    // on the open file, so nothing swapped in at the path since is touched.
+    struct stat owner;
+    const std::string reference = exists ? prefsPath : std::filesystem::path(prefsPath).parent_path().string();
+    const bool known = stat(reference.c_str(), &owner) == 0;
+    if (known && exists)
+    {
+        fchmod(fd, owner.st_mode & 0777);
+    }
+    if (known && (owner.st_uid != geteuid() || owner.st_gid != getegid())
+        && fchown(fd, owner.st_uid, owner.st_gid) != 0 && owner.st_uid != geteuid())
+    {
+        std::cerr << "Failed to give " << tempPath << " the owner of " << reference << ".\n";
+        discard();
+        return false;
+    }
+#else
+    const auto status = std::filesystem::status(prefsPath, ec);
+    if (!ec && std::filesystem::exists(status))
+    {
+        std::filesystem::permissions(tempPath, status.permissions(), ec);
+    }
+#endif
+
+    const bool writeFailed = ferror(out) != 0;
+    if (fclose(out) != 0 || writeFailed)
+    {
+        std::cerr << "Failed to write " << tempPath << ".\n";
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, prefsPath, ec);
+    if (ec)
+    {
+        std::cerr << "Failed to replace " << prefsPath << ": " << ec.message() << "\n";
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::string readPref(const std::string& prefsPath, const std::string& key)
+{
+    std::vector<char> buffer(1 << 16);
+    std::ifstream in;
+    in.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    in.open(prefsPath, std::ios::binary);
+
+    std::string value;
+    std::string line;
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        const std::string_view found = prefKey(line);
+        if (found == key)
+        {
+            value = prefValue(line, found);
+        }
+    }
+    return value;
+}
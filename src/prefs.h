@@ -0,0 +1,18 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// A pref and its value as a JavaScript literal, e.g. { "sine.version", "\"2.3c\"" }.
+using PrefValue = std::pair<std::string, std::string>;
+
+// Sets prefs in a prefs.js without letting it grow: the first user_pref line for
+// each key is rewritten in place, later duplicates are dropped and missing keys
+// are appended. The file is streamed line by line into a temporary file next to
+// it, which then replaces the original, so a crash never leaves it half written.
+bool upsertPrefs(const std::string& prefsPath, const std::vector<PrefValue>& prefs);
+
+// The value literal of the last user_pref line for key (the one Firefox ends up
+// using), or an empty string when prefs.js is missing or doesn't set it.
+std::string readPref(const std::string& prefsPath, const std::string& key);
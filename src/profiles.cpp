@@ -0,0 +1,160 @@
+#include <profiles.h>
+#include <data.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+
+std::string getOS()
+{
+#if defined(_WIN32) || defined(_WIN64)
+    return "win32";
+#elif defined(__APPLE__) || defined(__MACH__)
+    return "darwin";
+#elif defined(__linux__)
+    return "linux";
+#else
+    return "unsupported";
+#endif
+}
+
+std::string getBrowserLocation(int browserIndex, int versionIndex)
+{
+    std::string os = getOS();
+    std::vector<std::string> browserPaths = browsers[browserIndex].second[versionIndex + 1].second.find(os)->second;
+    for (std::string path : browserPaths)
+    {
+        if (std::filesystem::exists(path))
+        {
+            return path;
+        }
+    }
+    return "";
+}
+
+std::string getProfileLocation(int browserIndex)
+{
+    std::string os = getOS();
+    std::string profilePath = browsers[browserIndex].second[0].second.find(os)->second[0];
+    
+    if (os == "win32")
+    {
+        std::filesystem::path appData = std::getenv("APPDATA");
+        profilePath = (appData / profilePath / "Profiles").string();
+    }
+    else
+    {
+        std::filesystem::path home = std::getenv("HOME");
+        if (os == "darwin")
+        {
+            profilePath = (home / "Library" / "Application Support" / profilePath / "Profiles").string();
+        }
+        else if (os == "linux")
+        {
+            profilePath = (home / profilePath).string();
+        }
+    }
+
+    return profilePath;
+}
+
+BrowserLocations probeBrowserLocations()
+{
+    BrowserLocations locations;
+    for (size_t browser = 0; browser < browsers.size(); ++browser)
+    {
+        // The first entry of every browser is its "profile" folder, not a version.
+        std::vector<std::string> installs;
+        for (size_t version = 0; version + 1 < browsers[browser].second.size(); ++version)
+        {
+            installs.push_back(getBrowserLocation(static_cast<int>(browser), static_cast<int>(version)));
+        }
+        locations.installs.push_back(installs);
+        locations.profiles.push_back(getProfileLocation(static_cast<int>(browser)));
+    }
+    return locations;
+}
+
+// Same layout below another user's home folder, for --all-users.
+std::string getProfileLocation(int browserIndex, const std::filesystem::path& home)
+{
+    std::string os = getOS();
+    std::string profilePath = browsers[browserIndex].second[0].second.find(os)->second[0];
+
+    if (os == "win32")
+    {
+        return (home / "AppData" / "Roaming" / profilePath / "Profiles").string();
+    }
+    else if (os == "darwin")
+    {
+        return (home / "Library" / "Application Support" / profilePath / "Profiles").string();
+    }
+    return (home / profilePath).string();
+}
+
+std::vector<std::string> listUserHomes()
+{
+    std::vector<std::string> homes;
+    std::filesystem::path root;
+    std::vector<std::string> skip;
+
+    if (getOS() == "win32")
+    {
+        const char* drive = std::getenv("SystemDrive");
+        root = std::filesystem::path(drive ? drive : "C:") / "Users";
+        skip = { "All Users", "Default", "Default User", "Public" };
+    }
+    else if (getOS() == "darwin")
+    {
+        root = "/Users";
+        skip = { "Shared" };
+    }
+    else
+    {
+        root = "/home";
+        if (std::filesystem::is_directory("/root"))
+        {
+            homes.push_back("/root");
+        }
+    }
+
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(root, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if (!entry.is_directory(ec) || entry.is_symlink(ec) || name.empty() || name[0] == '.') continue;
+        if (std::find(skip.begin(), skip.end(), name) != skip.end()) continue;
+        homes.push_back(entry.path().string());
+    }
+
+    return homes;
+}
+
+
+std::vector<std::string> listProfiles(const std::string& profileFolderPath, bool showHidden)
+{
+    std::vector<std::string> profiles;
+    for (const auto& entry : std::filesystem::directory_iterator(profileFolderPath))
+    {
+        if (std::filesystem::is_directory(entry.status()))
+        {
+            std::string dirName = entry.path().filename().string();
+
+            if (showHidden)
+            {
+                profiles.push_back(dirName);
+                continue;
+            }
+
+            for (const auto& subEntry : std::filesystem::directory_iterator(entry.path()))
+            {
+                if (subEntry.path().filename() == "prefs.js")
+                {
+                    profiles.push_back(dirName);
+                    break;
+                }
+            }
+        }
+    }
+    return profiles;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// "win32", "darwin", "linux" or "unsupported"; the keys used in the browsers table.
+std::string getOS();
+
+std::string getBrowserLocation(int browserIndex, int versionIndex);
+// The folder holding a browser's profiles for the current user.
+std::string getProfileLocation(int browserIndex);
+
+// getBrowserLocation() for every browser and version, and getProfileLocation() for
+// every browser, probed once so the wizard does not touch the disk while drawing.
+struct BrowserLocations
+{
+    // Indexed like getBrowserLocation(): [browser][version].
+    std::vector<std::vector<std::string>> installs;
+    std::vector<std::string> profiles;
+};
+BrowserLocations probeBrowserLocations();
+std::string getProfileLocation(int browserIndex, const std::filesystem::path& home);
+
+// Home folders of the local users (plus /root on Linux), for --all-users.
+std::vector<std::string> listUserHomes();
+
+// Profile folders below a browser's profiles folder. Unless showHidden is set,
+// only folders that contain a prefs.js (i.e. have been used) are listed.
+std::vector<std::string> listProfiles(const std::string& profileFolderPath, bool showHidden);
@@ -0,0 +1,178 @@
+#include <progress.h>
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#define fdopen _fdopen
+#endif
+
+namespace
+{
+    std::mutex streamMutex;
+    FILE* stream = nullptr;
+    std::chrono::steady_clock::time_point origin;
+
+    std::string quote(const std::string& value)
+    {
+        std::string out = "\"";
+        for (char c : value)
+        {
+            switch (c)
+            {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                }
+                else
+                {
+                    out.push_back(c);
+                }
+            }
+        }
+        out.push_back('"');
+        return out;
+    }
+
+    // Starts a line with the event name and timestamp; the caller appends
+    // ",key:value" pairs and hands the stream to emit().
+    std::ostringstream begin(const char* event)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        std::ostringstream line;
+        line << "{\"event\":\"" << event << "\",\"t\":"
+            << std::chrono::duration_cast<std::chrono::milliseconds>(now - origin).count();
+        return line;
+    }
+
+    void emit(std::ostringstream& line)
+    {
+        line << "}\n";
+        const std::string text = line.str();
+
+        std::lock_guard<std::mutex> lock(streamMutex);
+        if (!stream) return;
+
+        // A closed pipe on the other end must not take the install down with it.
+        if (fwrite(text.data(), 1, text.size(), stream) != text.size() || fflush(stream) != 0)
+        {
+            stream = nullptr;
+        }
+    }
+}
+
+bool progressOpen(int fd)
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (stream) return true;
+
+    stream = fd == 1 ? stdout : fdopen(fd, "w");
+    if (!stream)
+    {
+        std::cerr << "Cannot write progress to file descriptor " << fd << ".\n";
+        return false;
+    }
+
+    origin = std::chrono::steady_clock::now();
+    return true;
+}
+
+void progressClose()
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    if (stream && stream != stdout)
+    {
+        fclose(stream);
+    }
+    stream = nullptr;
+}
+
+bool progressEnabled()
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    return stream != nullptr;
+}
+
+std::ostream& reportStream()
+{
+    std::lock_guard<std::mutex> lock(streamMutex);
+    return stream == stdout ? std::cerr : std::cout;
+}
+
+void progressStepStart(size_t step, size_t steps, const char* name)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("step_start");
+    line << ",\"step\":" << step << ",\"steps\":" << steps << ",\"name\":" << quote(name);
+    emit(line);
+}
+
+void progressStepEnd(size_t step, size_t steps, const char* name, bool ok, double ms)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("step_end");
+    line << ",\"step\":" << step << ",\"steps\":" << steps << ",\"name\":" << quote(name)
+        << ",\"ok\":" << (ok ? "true" : "false") << ",\"ms\":" << static_cast<int64_t>(ms);
+    emit(line);
+}
+
+void progressTransfer(const std::string& url, uint64_t bytes, uint64_t total, double bytesPerSecond)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("transfer");
+    line << ",\"url\":" << quote(url) << ",\"bytes\":" << bytes << ",\"total\":" << total
+        << ",\"bytes_per_s\":" << static_cast<uint64_t>(bytesPerSecond);
+    emit(line);
+}
+
+void progressExtract(const std::string& archive, uint64_t entries, uint64_t bytes)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("extract");
+    line << ",\"archive\":" << quote(archive) << ",\"entries\":" << entries << ",\"bytes\":" << bytes;
+    emit(line);
+}
+
+void progressError(const char* source, int code, const std::string& message)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("error");
+    line << ",\"source\":\"" << source << "\",\"code\":" << code << ",\"message\":" << quote(message);
+    emit(line);
+}
+
+void progressDone(bool ok, double ms, uint64_t transfers, uint64_t bytes)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("done");
+    line << ",\"ok\":" << (ok ? "true" : "false") << ",\"ms\":" << static_cast<int64_t>(ms)
+        << ",\"transfers\":" << transfers << ",\"bytes\":" << bytes;
+    emit(line);
+}
+
+void progressFirstFrame(double ms, double budgetMs)
+{
+    if (!progressEnabled()) return;
+
+    std::ostringstream line = begin("first_frame");
+    line << ",\"ms\":" << static_cast<int64_t>(ms) << ",\"budget_ms\":" << static_cast<int64_t>(budgetMs);
+    emit(line);
+}
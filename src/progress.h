@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Newline-delimited JSON progress for deployment tooling (--progress-fd N or
+// --json-progress for stdout). Every event is one object on its own line with
+// an "event" name and "t", milliseconds since the stream was opened:
+//
+//   {"event":"step_start","t":12,"step":0,"steps":9,"name":"Downloading program.zip..."}
+//   {"event":"transfer","t":80,"url":"...","bytes":65536,"total":1048576,"bytes_per_s":819200}
+//   {"event":"extract","t":95,"archive":"profile.zip","entries":412,"bytes":3145728}
+//   {"event":"error","t":96,"source":"curl","code":22,"message":"..."}
+//   {"event":"step_end","t":97,"step":0,"steps":9,"name":"...","ok":true,"ms":85}
+//   {"event":"done","t":900,"ok":true,"ms":900,"transfers":4,"bytes":12582912}
+//   {"event":"first_frame","t":140,"ms":152,"budget_ms":250}
+//
+// All calls are no-ops until progressOpen() succeeds, and safe from any thread.
+
+bool progressOpen(int fd);
+void progressClose();
+bool progressEnabled();
+// Where plain-text reports (batch, --verify, --rollback, --agent) go: stdout, or
+// stderr while the progress stream has stdout, so the NDJSON stays parseable.
+std::ostream& reportStream();
+
+void progressStepStart(size_t step, size_t steps, const char* name);
+void progressStepEnd(size_t step, size_t steps, const char* name, bool ok, double ms);
+void progressTransfer(const std::string& url, uint64_t bytes, uint64_t total, double bytesPerSecond);
+void progressExtract(const std::string& archive, uint64_t entries, uint64_t bytes);
+// source says what the code means: "curl" (CURLcode), "minizip" (MZ_* error),
+// "os" (errno, or GetLastError() on Windows), "sha256" (digest mismatch, or no
+// digest to check against, code 0), "write" (a download that could not be written
+// to disk, code 0), "delta" (unusable delta package, code 0), "preflight" (a problem the install
+// plan found before anything was written, code 0) or "install" (code 0).
+void progressError(const char* source, int code, const std::string& message);
+void progressDone(bool ok, double ms, uint64_t transfers, uint64_t bytes);
+// The wizard's time from launch to its first frame on screen, next to the budget it should stay under.
+void progressFirstFrame(double ms, double budgetMs);
@@ -0,0 +1,374 @@
+#include <sha256.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SINE_SHA_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SINE_TARGET_SHA
+#else
+#include <cpuid.h>
+#define SINE_TARGET_SHA __attribute__((target("sha,sse4.1,ssse3")))
+#endif
+#elif defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO)
+#define SINE_SHA_ARM 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    alignas(16) const uint32_t K[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    typedef void (*BlockFn)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+    inline uint32_t rotr(uint32_t x, int n)
+    {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    void compressScalar(uint32_t state[8], const uint8_t* data, size_t blocks)
+    {
+        uint32_t w[64];
+
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                w[i] = (uint32_t(data[i * 4]) << 24) | (uint32_t(data[i * 4 + 1]) << 16) |
+                       (uint32_t(data[i * 4 + 2]) << 8) | uint32_t(data[i * 4 + 3]);
+            }
+            for (int i = 16; i < 64; ++i)
+            {
+                uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+            for (int i = 0; i < 64; ++i)
+            {
+                uint32_t S1 = rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25);
+                uint32_t ch = (e & f) ^ (~e & g);
+                uint32_t t1 = h + S1 + ch + K[i] + w[i];
+                uint32_t S0 = rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22);
+                uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                uint32_t t2 = S0 + maj;
+
+                h = g; g = f; f = e; e = d + t1;
+                d = c; c = b; b = a; a = t1 + t2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    }
+
+#if SINE_SHA_X86
+    bool cpuHasShaNi()
+    {
+#ifdef _MSC_VER
+        int regs[4];
+        __cpuid(regs, 0);
+        if (regs[0] < 7) return false;
+        __cpuid(regs, 1);
+        const bool sse41 = (regs[2] & (1 << 19)) != 0;
+        const bool ssse3 = (regs[2] & (1 << 9)) != 0;
+        __cpuidex(regs, 7, 0);
+        return sse41 && ssse3 && (regs[1] & (1 << 29)) != 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+        const bool sse41 = (ecx & (1u << 19)) != 0;
+        const bool ssse3 = (ecx & (1u << 9)) != 0;
+        if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) return false;
+        return sse41 && ssse3 && (ebx & (1u << 29)) != 0;
+#endif
+    }
+
+// Four rounds on one message group, then one half of the schedule for later groups.
+#define SHANI_ROUNDS(m, i) \
+    MSG = _mm_add_epi32(m, _mm_load_si128(reinterpret_cast<const __m128i*>(&K[4 * (i)]))); \
+    STATE1 = _mm_sha256rnds2_epu32(STATE1, STATE0, MSG); \
+    MSG = _mm_shuffle_epi32(MSG, 0x0E); \
+    STATE0 = _mm_sha256rnds2_epu32(STATE0, STATE1, MSG)
+#define SHANI_MSG1(prev, cur) prev = _mm_sha256msg1_epu32(prev, cur)
+#define SHANI_MSG2(next, cur, prev) \
+    next = _mm_sha256msg2_epu32(_mm_add_epi32(next, _mm_alignr_epi8(cur, prev, 4)), cur)
+
+    SINE_TARGET_SHA
+    void compressShaNi(uint32_t state[8], const uint8_t* data, size_t blocks)
+    {
+        const __m128i MASK = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+        __m128i STATE0, STATE1, MSG, TMP, M0, M1, M2, M3;
+
+        TMP = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+        STATE1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+        TMP = _mm_shuffle_epi32(TMP, 0xB1);             // CDAB
+        STATE1 = _mm_shuffle_epi32(STATE1, 0x1B);       // EFGH
+        STATE0 = _mm_alignr_epi8(TMP, STATE1, 8);       // ABEF
+        STATE1 = _mm_blend_epi16(STATE1, TMP, 0xF0);    // CDGH
+
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            const __m128i ABEF_SAVE = STATE0;
+            const __m128i CDGH_SAVE = STATE1;
+
+            M0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), MASK);
+            SHANI_ROUNDS(M0, 0);
+
+            M1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)), MASK);
+            SHANI_ROUNDS(M1, 1);
+            SHANI_MSG1(M0, M1);
+
+            M2 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)), MASK);
+            SHANI_ROUNDS(M2, 2);
+            SHANI_MSG1(M1, M2);
+
+            M3 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)), MASK);
+            SHANI_ROUNDS(M3, 3);
+            SHANI_MSG2(M0, M3, M2);
+            SHANI_MSG1(M2, M3);
+
+            for (int g = 4; g < 12; g += 4)
+            {
+                SHANI_ROUNDS(M0, g);
+                SHANI_MSG2(M1, M0, M3);
+                SHANI_MSG1(M3, M0);
+
+                SHANI_ROUNDS(M1, g + 1);
+                SHANI_MSG2(M2, M1, M0);
+                SHANI_MSG1(M0, M1);
+
+                SHANI_ROUNDS(M2, g + 2);
+                SHANI_MSG2(M3, M2, M1);
+                SHANI_MSG1(M1, M2);
+
+                SHANI_ROUNDS(M3, g + 3);
+                SHANI_MSG2(M0, M3, M2);
+                SHANI_MSG1(M2, M3);
+            }
+
+            SHANI_ROUNDS(M0, 12);
+            SHANI_MSG2(M1, M0, M3);
+            SHANI_MSG1(M3, M0);
+
+            SHANI_ROUNDS(M1, 13);
+            SHANI_MSG2(M2, M1, M0);
+
+            SHANI_ROUNDS(M2, 14);
+            SHANI_MSG2(M3, M2, M1);
+
+            SHANI_ROUNDS(M3, 15);
+
+            STATE0 = _mm_add_epi32(STATE0, ABEF_SAVE);
+            STATE1 = _mm_add_epi32(STATE1, CDGH_SAVE);
+        }
+
+        TMP = _mm_shuffle_epi32(STATE0, 0x1B);          // FEBA
+        STATE1 = _mm_shuffle_epi32(STATE1, 0xB1);       // DCHG
+        STATE0 = _mm_blend_epi16(TMP, STATE1, 0xF0);    // DCBA
+        STATE1 = _mm_alignr_epi8(STATE1, TMP, 8);       // ABEF
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), STATE0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), STATE1);
+    }
+
+#undef SHANI_ROUNDS
+#undef SHANI_MSG1
+#undef SHANI_MSG2
+#endif
+
+#if SINE_SHA_ARM
+    void compressArm(uint32_t state[8], const uint8_t* data, size_t blocks)
+    {
+        uint32x4_t STATE0 = vld1q_u32(&state[0]);
+        uint32x4_t STATE1 = vld1q_u32(&state[4]);
+
+        for (; blocks > 0; --blocks, data += 64)
+        {
+            const uint32x4_t ABEF_SAVE = STATE0;
+            const uint32x4_t CDGH_SAVE = STATE1;
+
+            uint32x4_t M[4];
+            for (int i = 0; i < 4; ++i)
+            {
+                M[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + 16 * i)));
+            }
+
+            for (int g = 0; g < 16; ++g)
+            {
+                const int m = g & 3;
+                const uint32x4_t wk = vaddq_u32(M[m], vld1q_u32(&K[4 * g]));
+                if (g < 12)
+                {
+                    M[m] = vsha256su0q_u32(M[m], M[(m + 1) & 3]);
+                }
+
+                const uint32x4_t abef = STATE0;
+                STATE0 = vsha256hq_u32(STATE0, STATE1, wk);
+                STATE1 = vsha256h2q_u32(STATE1, abef, wk);
+
+                if (g < 12)
+                {
+                    M[m] = vsha256su1q_u32(M[m], M[(m + 2) & 3], M[(m + 3) & 3]);
+                }
+            }
+
+            STATE0 = vaddq_u32(STATE0, ABEF_SAVE);
+            STATE1 = vaddq_u32(STATE1, CDGH_SAVE);
+        }
+
+        vst1q_u32(&state[0], STATE0);
+        vst1q_u32(&state[4], STATE1);
+    }
+#endif
+
+    struct Backend
+    {
+        BlockFn fn;
+        const char* name;
+    };
+
+    Backend detectBackend()
+    {
+#if SINE_SHA_X86
+        if (cpuHasShaNi()) return { compressShaNi, "sha-ni" };
+#elif SINE_SHA_ARM
+        return { compressArm, "armv8" };
+#endif
+        return { compressScalar, "scalar" };
+    }
+
+    const Backend accelerated = detectBackend();
+    std::atomic<bool> scalarOnly{ false };
+
+    inline BlockFn blockFn()
+    {
+        return scalarOnly.load(std::memory_order_relaxed) ? compressScalar : accelerated.fn;
+    }
+}
+
+Sha256::Sha256()
+    : state{ 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 },
+      bufferLen(0),
+      totalLen(0)
+{
+}
+
+void Sha256::update(const void* data, size_t len)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(data);
+    const BlockFn compress = blockFn();
+    totalLen += len;
+
+    if (bufferLen > 0)
+    {
+        size_t take = std::min(len, sizeof(buffer) - bufferLen);
+        memcpy(buffer + bufferLen, in, take);
+        bufferLen += take;
+        in += take;
+        len -= take;
+
+        if (bufferLen < sizeof(buffer)) return;
+
+        compress(state, buffer, 1);
+        bufferLen = 0;
+    }
+
+    if (len >= 64)
+    {
+        compress(state, in, len / 64);
+        in += len & ~size_t(63);
+        len &= 63;
+    }
+
+    if (len > 0)
+    {
+        memcpy(buffer, in, len);
+        bufferLen = len;
+    }
+}
+
+std::array<uint8_t, 32> Sha256::finish()
+{
+    const uint64_t bitLen = totalLen * 8;
+    const uint8_t pad = 0x80;
+    const uint8_t zeros[64] = {};
+
+    update(&pad, 1);
+    update(zeros, (bufferLen <= 56) ? 56 - bufferLen : 120 - bufferLen);
+
+    uint8_t lenBytes[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        lenBytes[i] = static_cast<uint8_t>(bitLen >> (56 - 8 * i));
+    }
+    update(lenBytes, 8);
+
+    std::array<uint8_t, 32> digest;
+    for (int i = 0; i < 8; ++i)
+    {
+        digest[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        digest[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        digest[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        digest[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+    return digest;
+}
+
+std::string Sha256::finishHex()
+{
+    static const char hex[] = "0123456789abcdef";
+    const std::array<uint8_t, 32> digest = finish();
+
+    std::string out;
+    out.reserve(64);
+    for (uint8_t byte : digest)
+    {
+        out.push_back(hex[byte >> 4]);
+        out.push_back(hex[byte & 0x0f]);
+    }
+    return out;
+}
+
+const char* Sha256::backend()
+{
+    return scalarOnly.load() ? "scalar" : accelerated.name;
+}
+
+void Sha256::forceScalar(bool scalar)
+{
+    scalarOnly.store(scalar);
+}
+
+std::string sha256File(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return "";
+
+    Sha256 hash;
+    std::vector<char> chunk(1 << 16);
+    while (file)
+    {
+        file.read(chunk.data(), chunk.size());
+        hash.update(chunk.data(), static_cast<size_t>(file.gcount()));
+    }
+    return hash.finishHex();
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Incremental SHA-256. Blocks are compressed with SHA-NI (x86) or the ARMv8
+// crypto extensions when available, otherwise with the portable scalar code.
+class Sha256
+{
+public:
+    Sha256();
+
+    void update(const void* data, size_t len);
+    std::array<uint8_t, 32> finish();
+    std::string finishHex();
+
+    // Name of the block implementation picked for this CPU ("sha-ni", "armv8", "scalar").
+    static const char* backend();
+
+    // Forces the portable implementation; used to benchmark against the accelerated one.
+    static void forceScalar(bool scalar);
+
+private:
+    uint32_t state[8];
+    uint8_t buffer[64];
+    size_t bufferLen;
+    uint64_t totalLen;
+};
+
+std::string sha256File(const std::string& path);
@@ -0,0 +1,48 @@
+#include <throttle.h>
+
+#include <thread>
+
+namespace
+{
+    constexpr std::chrono::milliseconds burst(250);
+
+    TokenBucket writes;
+}
+
+void TokenBucket::setRate(int64_t rate)
+{
+    bytesPerSecond = rate > 0 ? rate : 0;
+}
+
+void TokenBucket::take(uint64_t bytes)
+{
+    const int64_t rate = bytesPerSecond;
+    if (rate <= 0 || bytes == 0) return;
+
+    std::chrono::steady_clock::duration wait;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto now = std::chrono::steady_clock::now();
+        if (due < now - burst) due = now - burst;
+
+        // Reserve the slot before sleeping, so concurrent callers queue up behind it.
+        due += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(bytes) / static_cast<double>(rate)));
+        wait = due - now;
+    }
+
+    if (wait > std::chrono::steady_clock::duration::zero())
+    {
+        std::this_thread::sleep_for(wait);
+    }
+}
+
+void setWriteLimit(int64_t bytesPerSecond)
+{
+    writes.setRate(bytesPerSecond);
+}
+
+void throttleWrite(uint64_t bytes)
+{
+    writes.take(bytes);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// Paces a stream of work shared by any number of threads to a rate in bytes per
+// second. Up to a quarter second of unused rate may be spent at once, so short
+// pauses do not lose throughput and bursts stay small.
+class TokenBucket
+{
+public:
+    // 0 lets everything through.
+    void setRate(int64_t bytesPerSecond);
+    int64_t rate() const { return bytesPerSecond; }
+
+    // Blocks until bytes fit under the rate.
+    void take(uint64_t bytes);
+
+private:
+    std::atomic<int64_t> bytesPerSecond{ 0 };
+    std::mutex mutex;
+    // When everything taken so far has been paid for.
+    std::chrono::steady_clock::time_point due;
+};
+
+// Ceiling for the bytes extraction writes out, 0 for none (the default).
+void setWriteLimit(int64_t bytesPerSecond);
+void throttleWrite(uint64_t bytes);
+
+// What --background caps downloads and extraction writes to unless --net-limit or
+// --write-limit say otherwise. Low enough to leave a shared host's disk and uplink
+// to its users, high enough to finish an install within a couple of minutes.
+constexpr int64_t backgroundNetworkLimit = 4 << 20;
+constexpr int64_t backgroundWriteLimit = 16 << 20;
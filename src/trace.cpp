@@ -0,0 +1,209 @@
+#include <trace.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+namespace
+{
+    struct TraceRecord
+    {
+        const char* name;
+        const char* category;
+        int64_t start;
+        int64_t duration;
+        uint32_t thread;
+        char detail[traceDetailSize];
+    };
+
+    // 64k events (~8 MB, only allocated when tracing). A full install records a
+    // few thousand; past the capacity the oldest events are overwritten.
+    constexpr uint64_t traceCapacity = 1 << 16;
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<uint64_t> head{ 0 };
+    std::atomic<uint32_t> nextThread{ 0 };
+    std::unique_ptr<TraceRecord[]> ring;
+    std::string outputPath;
+    std::chrono::steady_clock::time_point origin;
+    bool registeredAtExit = false;
+
+    uint32_t threadId()
+    {
+        thread_local uint32_t id = nextThread.fetch_add(1, std::memory_order_relaxed) + 1;
+        return id;
+    }
+
+    void writeString(std::ostream& out, const char* value)
+    {
+        out << '"';
+        for (const char* c = value; *c; ++c)
+        {
+            switch (*c)
+            {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            case '\t': out << "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(*c) < 0x20)
+                {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+                    out << escaped;
+                }
+                else
+                {
+                    out << *c;
+                }
+            }
+        }
+        out << '"';
+    }
+
+    void atExit()
+    {
+        traceClose();
+    }
+}
+
+bool traceOpen(const std::string& path)
+{
+    if (enabled) return true;
+
+    std::ofstream probe(path);
+    if (!probe)
+    {
+        std::cerr << "Cannot write trace to " << path << ".\n";
+        return false;
+    }
+
+    ring.reset(new TraceRecord[traceCapacity]);
+    head = 0;
+    outputPath = path;
+    origin = std::chrono::steady_clock::now();
+    threadId();
+
+    if (!registeredAtExit)
+    {
+        std::atexit(atExit);
+        registeredAtExit = true;
+    }
+
+    enabled.store(true, std::memory_order_release);
+    return true;
+}
+
+void traceClose()
+{
+    if (!enabled.exchange(false)) return;
+
+    const uint64_t count = head.load(std::memory_order_acquire);
+    const uint64_t first = count > traceCapacity ? count - traceCapacity : 0;
+
+    std::ofstream out(outputPath);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"sine_installer\"}}";
+
+    const uint32_t threads = nextThread.load(std::memory_order_relaxed);
+    for (uint32_t tid = 1; tid <= threads; ++tid)
+    {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << (tid == 1 ? "main" : "thread " + std::to_string(tid)) << "\"}}";
+    }
+
+    for (uint64_t i = first; i < count; ++i)
+    {
+        const TraceRecord& record = ring[i % traceCapacity];
+        out << ",\n{\"name\":";
+        writeString(out, record.name);
+        out << ",\"cat\":";
+        writeString(out, record.category);
+        out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << record.thread
+            << ",\"ts\":" << record.start << ",\"dur\":" << record.duration;
+        if (record.detail[0])
+        {
+            out << ",\"args\":{\"detail\":";
+            writeString(out, record.detail);
+            out << "}";
+        }
+        out << "}";
+    }
+
+    out << "\n]}\n";
+
+    if (first > 0)
+    {
+        std::cerr << "Trace buffer overflowed, " << first << " early events were dropped.\n";
+    }
+    if (!out)
+    {
+        std::cerr << "Failed to write trace to " << outputPath << ".\n";
+    }
+
+    ring.reset();
+}
+
+bool traceEnabled()
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+int64_t traceNow()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void traceEvent(const char* name, const char* category, int64_t start, int64_t duration, const char* detail)
+{
+    if (!enabled.load(std::memory_order_acquire)) return;
+
+    TraceRecord& record = ring[head.fetch_add(1, std::memory_order_acq_rel) % traceCapacity];
+    record.name = name;
+    record.category = category;
+    record.start = start;
+    record.duration = duration;
+    record.thread = threadId();
+
+    if (detail)
+    {
+        std::strncpy(record.detail, detail, sizeof(record.detail) - 1);
+        record.detail[sizeof(record.detail) - 1] = '\0';
+    }
+    else
+    {
+        record.detail[0] = '\0';
+    }
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category, const char* detail)
+    : name(name), category(category), start(0)
+{
+    this->detail[0] = '\0';
+    if (!name || !traceEnabled()) return;
+
+    if (detail)
+    {
+        std::strncpy(this->detail, detail, sizeof(this->detail) - 1);
+        this->detail[sizeof(this->detail) - 1] = '\0';
+    }
+    start = traceNow();
+}
+
+TraceSpan::TraceSpan(const char* name, const char* category, const std::string& detail)
+    : TraceSpan(name, category, detail.c_str())
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (name && traceEnabled())
+    {
+        traceEvent(name, category, start, traceNow() - start, detail[0] ? detail : nullptr);
+    }
+}
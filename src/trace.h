@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Opt-in timeline tracing (--trace out.json). Events go into a fixed ring buffer
+// with a single atomic increment per event and are written as Chrome Trace Event
+// JSON when tracing stops (or at exit), so the file opens in Perfetto or
+// chrome://tracing. When tracing is off every call is a relaxed load and a branch.
+//
+// Event names and categories must be string literals (or otherwise outlive the
+// trace); the optional detail is copied and truncated.
+
+bool traceOpen(const std::string& path);
+// Writes the file and disables tracing. Threads that record events must have
+// finished by then. Safe to call more than once.
+void traceClose();
+bool traceEnabled();
+
+// Microseconds since traceOpen().
+int64_t traceNow();
+
+// A complete event measured elsewhere, e.g. curl's phase timings.
+void traceEvent(const char* name, const char* category, int64_t start, int64_t duration, const char* detail = nullptr);
+
+constexpr size_t traceDetailSize = 100;
+
+// A null name records nothing, for call sites that only sometimes want a span.
+class TraceSpan
+{
+public:
+    TraceSpan(const char* name, const char* category, const char* detail = nullptr);
+    TraceSpan(const char* name, const char* category, const std::string& detail);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    int64_t start;
+    char detail[traceDetailSize];
+};
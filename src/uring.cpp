@@ -0,0 +1,324 @@
+#include <uring.h>
+
+#include <algorithm>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+// Headers from before 5.17 lack what the chains rely on.
+#ifdef IORING_FEAT_LINKED_FILE
+#define SINE_HAVE_URING 1
+#endif
+#endif
+
+#ifdef SINE_HAVE_URING
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef SINE_HAVE_URING
+namespace
+{
+    constexpr unsigned opsPerFile = 4;
+    constexpr unsigned ringEntries = UringWriter::batchSize * opsPerFile;
+    constexpr mode_t fileMode = 0644;
+
+    int setupRing(unsigned entries, io_uring_params* params)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int enterRing(int fd, unsigned submit, unsigned wait)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_enter, fd, submit, wait, IORING_ENTER_GETEVENTS, nullptr, 0));
+    }
+
+    int registerRing(int fd, unsigned opcode, const void* arg, unsigned count)
+    {
+        return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+    }
+
+    // openat creates files as 0644 minus the umask; io_uring has no fchmod, so
+    // files only get a chmod of their own when the umask takes some of that away.
+    bool umaskStripsFileMode()
+    {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.rfind("Umask:", 0) == 0)
+            {
+                return (std::stoul(line.substr(6), nullptr, 8) & fileMode) != 0;
+            }
+        }
+        return true;
+    }
+}
+
+struct UringWriter::Ring
+{
+    int fd = -1;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    size_t sqRingSize = 0;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize = 0;
+
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    bool chmodFiles = true;
+
+    bool open()
+    {
+        io_uring_params params = {};
+        fd = setupRing(ringEntries, &params);
+        if (fd < 0) return false;
+
+        // The write and close of a chain find their file through the slot the openat
+        // before them filled, which needs the files of linked requests to be looked up
+        // when they run rather than when they are queued (Linux 5.17).
+        if (!(params.features & IORING_FEAT_LINKED_FILE)) return false;
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        if (params.features & IORING_FEAT_SINGLE_MMAP)
+        {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) return false;
+        cqRing = (params.features & IORING_FEAT_SINGLE_MMAP)
+            ? sqRing
+            : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) return false;
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) return false;
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // One direct descriptor slot per file in flight, so a chain never needs
+        // the descriptor of an earlier operation in user space.
+        std::vector<int> slots(UringWriter::batchSize, -1);
+        if (registerRing(fd, IORING_REGISTER_FILES, slots.data(), static_cast<unsigned>(slots.size())) < 0)
+        {
+            return false;
+        }
+
+        chmodFiles = umaskStripsFileMode();
+        return true;
+    }
+
+    void close()
+    {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+    }
+
+    io_uring_sqe* next(unsigned& tail, uint8_t opcode, uint64_t userData, uint8_t flags)
+    {
+        const unsigned index = tail & sqMask;
+        io_uring_sqe* sqe = &sqes[index];
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = opcode;
+        sqe->flags = flags;
+        sqe->user_data = userData;
+        sqArray[index] = index;
+        ++tail;
+        return sqe;
+    }
+
+    // Queues the chain for one file. A failed unlink (usually ENOENT) must not
+    // cancel the rest, hence the hard link; after that any failure cancels the chain.
+    void queueFile(unsigned& tail, unsigned slot, const UringWriter::File& file)
+    {
+        const uint64_t tag = uint64_t(slot) << 8;
+
+        io_uring_sqe* sqe = next(tail, IORING_OP_UNLINKAT, tag | IORING_OP_UNLINKAT, IOSQE_IO_HARDLINK);
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(file.path.c_str());
+
+        sqe = next(tail, IORING_OP_OPENAT, tag | IORING_OP_OPENAT, IOSQE_IO_LINK);
+        sqe->fd = AT_FDCWD;
+        sqe->addr = reinterpret_cast<uint64_t>(file.path.c_str());
+        // Direct descriptors never reach a child process; O_CLOEXEC is rejected for them.
+        sqe->open_flags = O_WRONLY | O_CREAT | O_TRUNC;
+        sqe->len = fileMode;
+        sqe->file_index = slot + 1;
+
+        sqe = next(tail, IORING_OP_WRITE, tag | IORING_OP_WRITE, IOSQE_IO_LINK | IOSQE_FIXED_FILE);
+        sqe->fd = static_cast<int>(slot);
+        sqe->addr = reinterpret_cast<uint64_t>(file.data.data());
+        sqe->len = static_cast<unsigned>(file.data.size());
+        sqe->off = 0;
+
+        sqe = next(tail, IORING_OP_CLOSE, tag | IORING_OP_CLOSE, 0);
+        sqe->file_index = slot + 1;
+    }
+
+    // Submits the chains and collects the completions; failed[slot] is set for
+    // every file whose open, write or close did not go through completely.
+    bool run(const std::vector<UringWriter::File>& files, size_t first, size_t count, std::vector<bool>& failed)
+    {
+        unsigned tail = *sqTail;
+        for (size_t i = 0; i < count; ++i)
+        {
+            queueFile(tail, static_cast<unsigned>(i), files[first + i]);
+        }
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+        unsigned submit = static_cast<unsigned>(count) * opsPerFile;
+        unsigned outstanding = submit;
+        while (outstanding > 0)
+        {
+            const int entered = enterRing(fd, submit, outstanding);
+            if (entered < 0 && errno != EINTR) return false;
+            if (entered > 0) submit -= std::min<unsigned>(submit, static_cast<unsigned>(entered));
+
+            unsigned head = *cqHead;
+            const unsigned ready = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+            for (; head != ready; ++head)
+            {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                const size_t slot = static_cast<size_t>(cqe.user_data >> 8);
+                const uint8_t op = static_cast<uint8_t>(cqe.user_data & 0xff);
+                if (slot < count && op != IORING_OP_UNLINKAT)
+                {
+                    const bool shortWrite = op == IORING_OP_WRITE && cqe.res >= 0
+                        && static_cast<size_t>(cqe.res) != files[first + slot].data.size();
+                    if (cqe.res < 0 || shortWrite) failed[slot] = true;
+                }
+                --outstanding;
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+        return true;
+    }
+};
+
+UringWriter::UringWriter() : ring(new Ring)
+{
+    if (!ring->open())
+    {
+        ring->close();
+        delete ring;
+        ring = nullptr;
+    }
+}
+
+UringWriter::~UringWriter()
+{
+    if (ring)
+    {
+        ring->close();
+        delete ring;
+    }
+}
+
+bool UringWriter::available() const
+{
+    return ring != nullptr;
+}
+
+std::vector<UringWriter::File> UringWriter::flush()
+{
+    std::vector<File> retry;
+    if (!ring)
+    {
+        retry.swap(queue);
+        return retry;
+    }
+
+    for (size_t first = 0; first < queue.size(); first += batchSize)
+    {
+        const size_t count = std::min<size_t>(batchSize, queue.size() - first);
+        std::vector<bool> failed(count, false);
+        if (!ring->run(queue, first, count, failed))
+        {
+            // The ring itself broke; everything still queued goes the portable way.
+            for (size_t i = first; i < queue.size(); ++i)
+            {
+                retry.push_back(std::move(queue[i]));
+            }
+            ring->close();
+            delete ring;
+            ring = nullptr;
+            break;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (failed[i])
+            {
+                retry.push_back(std::move(queue[first + i]));
+            }
+            else if (ring->chmodFiles)
+            {
+                chmod(queue[first + i].path.c_str(), fileMode);
+            }
+        }
+    }
+
+    queue.clear();
+    return retry;
+}
+#else
+struct UringWriter::Ring
+{
+};
+
+UringWriter::UringWriter() : ring(nullptr)
+{
+}
+
+UringWriter::~UringWriter()
+{
+}
+
+bool UringWriter::available() const
+{
+    return false;
+}
+
+std::vector<UringWriter::File> UringWriter::flush()
+{
+    std::vector<File> retry;
+    retry.swap(queue);
+    return retry;
+}
+#endif
+
+void UringWriter::add(std::string path, std::vector<uint8_t> data)
+{
+    queue.push_back({ std::move(path), std::move(data) });
+}
+
+bool UringWriter::full() const
+{
+    return queue.size() >= batchSize;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Writes batches of small files through io_uring on Linux. Each file is one
+// chain of linked operations (unlink, openat into a direct descriptor, write,
+// close), and a whole batch of chains goes to the kernel with a single system
+// call. The ring is set up with raw syscalls, so there is no liburing
+// dependency; on other platforms, old kernels or when io_uring is disabled,
+// available() is false and callers write the portable way.
+class UringWriter
+{
+public:
+    struct File
+    {
+        std::string path;
+        std::vector<uint8_t> data;
+    };
+
+    UringWriter();
+    ~UringWriter();
+
+    UringWriter(const UringWriter&) = delete;
+    UringWriter& operator=(const UringWriter&) = delete;
+
+    bool available() const;
+
+    // Queues a file (the parent folder must exist). Once batchSize files are
+    // queued, full() says it is time to flush.
+    void add(std::string path, std::vector<uint8_t> data);
+    bool full() const;
+
+    // Submits everything queued and waits for it. Files the kernel could not
+    // write are handed back, data included, for the caller to retry.
+    std::vector<File> flush();
+
+    // Files in flight at once; each takes four submission queue entries.
+    static constexpr unsigned batchSize = 64;
+
+private:
+    struct Ring;
+    Ring* ring;
+    std::vector<File> queue;
+};
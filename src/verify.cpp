@@ -0,0 +1,291 @@
+#include <verify.h>
+#include <crc32.h>
+#include <data.h>
+#include <install.h>
+#include <mirrors.h>
+#include <net.h>
+#include <payload.h>
+#include <platform.h>
+#include <progress.h>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <minizip-ng/mz.h>
+#include <minizip-ng/mz_zip.h>
+#include <minizip-ng/mz_zip_rw.h>
+
+namespace
+{
+    struct ArchiveEntry
+    {
+        std::string name;
+        uint32_t crc;
+        int64_t size;
+    };
+
+    enum class FileStatus
+    {
+        OK,
+        MISSING,
+        MODIFIED,
+        UNREADABLE
+    };
+
+    struct FileCheck
+    {
+        std::string archive;
+        std::string relative;
+        std::filesystem::path path;
+        uint32_t crc;
+        int64_t size;
+        FileStatus status = FileStatus::OK;
+    };
+
+    // Only the central directory is read; no entry is inflated.
+    bool readCentralDirectory(const std::string& zipPath, const PayloadEntry* embedded, std::vector<ArchiveEntry>& entries)
+    {
+        void* reader = mz_zip_reader_create();
+        int32_t opened = embedded
+            ? mz_zip_reader_open_buffer(reader, const_cast<uint8_t*>(embedded->data), static_cast<int32_t>(embedded->size), 0)
+            : mz_zip_reader_open_file(reader, zipPath.c_str());
+        if (opened != MZ_OK)
+        {
+            mz_zip_reader_delete(&reader);
+            return false;
+        }
+
+        int32_t err = mz_zip_reader_goto_first_entry(reader);
+        while (err == MZ_OK)
+        {
+            mz_zip_file* info = nullptr;
+            if (mz_zip_reader_entry_get_info(reader, &info) == MZ_OK &&
+                mz_zip_reader_entry_is_dir(reader) != MZ_OK)
+            {
+                entries.push_back({ info->filename, info->crc, info->uncompressed_size });
+            }
+            err = mz_zip_reader_goto_next_entry(reader);
+        }
+
+        mz_zip_reader_close(reader);
+        mz_zip_reader_delete(&reader);
+        return err == MZ_END_OF_LIST;
+    }
+
+    void checkFile(FileCheck& check)
+    {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(check.path, ec);
+        if (ec)
+        {
+            check.status = std::filesystem::exists(check.path, ec) ? FileStatus::UNREADABLE : FileStatus::MISSING;
+            return;
+        }
+
+        // A size mismatch settles it without reading the file.
+        if (static_cast<int64_t>(size) != check.size)
+        {
+            check.status = FileStatus::MODIFIED;
+            return;
+        }
+
+        uint32_t crc = 0;
+        if (!crc32File(check.path.string(), crc))
+        {
+            check.status = FileStatus::UNREADABLE;
+            return;
+        }
+
+        check.status = (crc == check.crc) ? FileStatus::OK : FileStatus::MODIFIED;
+    }
+
+    void checkInParallel(std::vector<FileCheck>& checks)
+    {
+        // Small files dominate, so the work is handed out one entry at a time.
+        std::atomic<size_t> next{ 0 };
+        const size_t workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), 16));
+
+        auto work = [&]() {
+            for (size_t i = next++; i < checks.size(); i = next++)
+            {
+                checkFile(checks[i]);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < workers; ++i)
+        {
+            threads.emplace_back(work);
+        }
+        work();
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    std::string normalise(const std::filesystem::path& path)
+    {
+        return path.lexically_normal().generic_string();
+    }
+}
+
+int runVerify(const VerifyOptions& options)
+{
+    if (options.profilePath.empty())
+    {
+        std::cerr << "--verify needs --profile <path> (and optionally --browser <path>).\n";
+        return 2;
+    }
+
+    struct Archive
+    {
+        std::string name;
+        std::string url;
+        std::filesystem::path target;
+    };
+
+    const std::filesystem::path chrome = std::filesystem::path(options.profilePath) / "chrome";
+    std::vector<Archive> archives;
+    if (!options.browserPath.empty())
+    {
+        archives.push_back({ "program.zip", bootloaderReleases + bootVersion + "/program.zip", options.browserPath });
+    }
+    archives.push_back({ "profile.zip", bootloaderReleases + bootVersion + "/profile.zip", chrome });
+    archives.push_back({ "engine.zip", sineReleases + sineVersion + "/engine.zip", chrome });
+    archives.push_back({ "locales.zip", sineReleases + sineVersion + "/locales.zip", chrome });
+
+    std::error_code ec;
+    // Made on first use, private to this run (see makePrivateTempDir()).
+    std::filesystem::path tempDir;
+
+    // Locales the install left out on purpose are not missing.
+    const EntryFilter locales = localeFilter(options.profilePath);
+
+    std::vector<FileCheck> checks;
+    std::set<std::string> expected;
+    std::set<std::string> ownedDirs;
+    int result = 0;
+
+    for (const Archive& archive : archives)
+    {
+        const PayloadEntry* embedded = findPayload(archive.name);
+        std::filesystem::path zipPath = std::filesystem::path(options.archiveDir) / archive.name;
+        if (!embedded && !std::filesystem::exists(zipPath))
+        {
+            // Nothing cached; fetch a copy outside the audited folders.
+            if (tempDir.empty())
+            {
+                tempDir = makePrivateTempDir("sine-verify");
+                if (tempDir.empty())
+                {
+                    std::cerr << "Could not create a folder for " << archive.name << ".\n";
+                    result = 2;
+                    break;
+                }
+            }
+            zipPath = tempDir / archive.name;
+
+            if (!digestAvailable(archive.name) || !downloadMirrored(archive.url, zipPath.string(), pinnedDigest(archive.name)))
+            {
+                std::cerr << "Could not obtain " << archive.name << ".\n";
+                result = 2;
+                break;
+            }
+        }
+
+        std::vector<ArchiveEntry> entries;
+        if (!readCentralDirectory(zipPath.string(), embedded, entries))
+        {
+            std::cerr << "Could not read " << zipPath.string() << ".\n";
+            result = 2;
+            break;
+        }
+
+        for (const ArchiveEntry& entry : entries)
+        {
+            if (locales && archive.name == "locales.zip" && !locales(entry.name))
+            {
+                continue;
+            }
+
+            FileCheck check;
+            check.archive = archive.name;
+            check.relative = entry.name;
+            check.path = archive.target / entry.name;
+            check.crc = entry.crc;
+            check.size = entry.size;
+            expected.insert(normalise(check.path));
+            checks.push_back(std::move(check));
+
+            // Folders the archives own inside chrome/ are scanned for leftovers.
+            const size_t slash = entry.name.find('/');
+            if (archive.target == chrome && slash != std::string::npos)
+            {
+                ownedDirs.insert(entry.name.substr(0, slash));
+            }
+        }
+    }
+
+    if (!tempDir.empty())
+    {
+        std::filesystem::remove_all(tempDir, ec);
+    }
+
+    if (result != 0)
+    {
+        return result;
+    }
+
+    checkInParallel(checks);
+
+    size_t missing = 0, modified = 0, unreadable = 0, extra = 0;
+    for (const FileCheck& check : checks)
+    {
+        switch (check.status)
+        {
+        case FileStatus::MISSING:
+            reportStream() << "missing    " << check.path.string() << " (" << check.archive << ")\n";
+            ++missing;
+            break;
+        case FileStatus::MODIFIED:
+            reportStream() << "modified   " << check.path.string() << " (" << check.archive << ")\n";
+            ++modified;
+            break;
+        case FileStatus::UNREADABLE:
+            reportStream() << "unreadable " << check.path.string() << " (" << check.archive << ")\n";
+            ++unreadable;
+            break;
+        default:
+            break;
+        }
+    }
+
+    for (const std::string& dir : ownedDirs)
+    {
+        const std::filesystem::path root = chrome / dir;
+        if (!std::filesystem::is_directory(root, ec)) continue;
+
+        for (auto it = std::filesystem::recursive_directory_iterator(root, ec);
+             it != std::filesystem::recursive_directory_iterator(); it.increment(ec))
+        {
+            if (ec) break;
+            if (it->is_regular_file(ec) && expected.count(normalise(it->path())) == 0)
+            {
+                reportStream() << "extra      " << it->path().string() << "\n";
+                ++extra;
+            }
+        }
+    }
+
+    reportStream() << checks.size() << " files checked (crc32: " << crc32Backend() << "): "
+        << missing << " missing, " << modified << " modified, "
+        << unreadable << " unreadable, " << extra << " extra.\n";
+
+    return (missing || modified || unreadable || extra) ? 1 : 0;
+}
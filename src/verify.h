@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+struct VerifyOptions
+{
+    std::string browserPath;
+    std::string profilePath;
+    // Where program.zip, profile.zip, engine.zip and locales.zip are looked up when
+    // the executable carries no payload. Missing archives are fetched into a temporary folder.
+    std::string archiveDir;
+};
+
+// Audits an installed profile (and browser folder when given) against the release
+// archives without modifying either. Returns 0 when everything matches, 1 when
+// files are missing, modified or extra, and 2 when the audit could not run.
+int runVerify(const VerifyOptions& options);
@@ -0,0 +1,20 @@
+// Builds the delta package (see src/delta.h) that updates what one release archive
+// installed to the next release, to be published next to the full archive as
+// "<archive>-from-<old version>.delta".
+//
+//   sine_make_delta <old version> <old.zip> <new version> <new.zip> <output>
+
+#include <delta.h>
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc != 6)
+    {
+        std::cerr << "usage: sine_make_delta <old version> <old.zip> <new version> <new.zip> <output>\n";
+        return 2;
+    }
+
+    return makeDelta(argv[2], argv[4], argv[1], argv[3], argv[5]) ? 0 : 1;
+}
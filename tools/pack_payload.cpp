@@ -0,0 +1,98 @@
+// Builds the offline installer: copies the installer executable and appends the
+// release archives plus the index described in src/payload.h.
+//
+//   sine_pack_payload <installer> <output> <archive.zip>...
+
+#include <payload.h>
+
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static void writeU32(std::ofstream& out, uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.put(static_cast<char>(v >> (8 * i)));
+}
+
+static void writeU64(std::ofstream& out, uint64_t v)
+{
+    for (int i = 0; i < 8; ++i) out.put(static_cast<char>(v >> (8 * i)));
+}
+
+static bool append(std::ofstream& out, const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    out << in.rdbuf();
+    return static_cast<bool>(out);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 4)
+    {
+        std::cerr << "usage: sine_pack_payload <installer> <output> <archive.zip>...\n";
+        return 2;
+    }
+
+    std::ofstream out(argv[2], std::ios::binary | std::ios::trunc);
+    if (!out || !append(out, argv[1]))
+    {
+        std::cerr << "Could not copy " << argv[1] << " to " << argv[2] << ".\n";
+        return 1;
+    }
+
+    struct Record
+    {
+        std::string name;
+        uint64_t offset;
+        uint64_t size;
+    };
+    std::vector<Record> records;
+
+    for (int i = 3; i < argc; ++i)
+    {
+        const uint64_t offset = static_cast<uint64_t>(out.tellp());
+        if (!append(out, argv[i]))
+        {
+            std::cerr << "Could not append " << argv[i] << ".\n";
+            return 1;
+        }
+        records.push_back({
+            std::filesystem::path(argv[i]).filename().string(),
+            offset,
+            static_cast<uint64_t>(out.tellp()) - offset
+        });
+    }
+
+    const uint64_t indexOffset = static_cast<uint64_t>(out.tellp());
+    for (const Record& record : records)
+    {
+        writeU32(out, static_cast<uint32_t>(record.name.size()));
+        out.write(record.name.data(), record.name.size());
+        writeU64(out, record.offset);
+        writeU64(out, record.size);
+    }
+
+    writeU32(out, static_cast<uint32_t>(records.size()));
+    writeU64(out, indexOffset);
+    out.write(payloadMagic, sizeof(payloadMagic) - 1);
+    out.close();
+
+    if (!out)
+    {
+        std::cerr << "Could not write " << argv[2] << ".\n";
+        return 1;
+    }
+
+    std::filesystem::permissions(argv[2],
+        std::filesystem::perms::owner_exec | std::filesystem::perms::group_exec | std::filesystem::perms::others_exec,
+        std::filesystem::perm_options::add);
+
+    std::cout << "Packed " << records.size() << " archives into " << argv[2] << ".\n";
+    return 0;
+}